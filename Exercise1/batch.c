@@ -0,0 +1,632 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "batch.h"
+#include "parallel.h"
+
+typedef struct Batch_Job Batch_Job_t;
+typedef void (*Batch_Kernel_t) (const Batch_Job_t* job, size_t first_lane, size_t end_lane);
+
+struct Batch_Job {
+	Batch_Kernel_t kernel;
+	const unsigned int* a;
+	const unsigned int* b;
+	unsigned int* c;
+	size_t stride;
+	unsigned int count;
+	unsigned int rows; /* rows of a and c */
+	unsigned int inner; /* cols of a and rows of b, multiply only */
+	unsigned int cols; /* cols of b and c */
+	char direction;
+	unsigned int shift;
+	unsigned long long* sums;
+	unsigned char* equal;
+};
+
+typedef struct {
+	Batch_Kernel_t add;
+	Batch_Kernel_t shift;
+	Batch_Kernel_t sum;
+	Batch_Kernel_t equal;
+	Batch_Kernel_t multiply;
+}Batch_Kernels_t;
+
+/*protected functions*/
+static void run_batch_job (Batch_Job_t* job, Batch_Kernel_t kernel);
+static void batch_lane_range (unsigned int first_group, unsigned int end_group, unsigned int worker, void* arg);
+static const Batch_Kernels_t* square_kernels (unsigned int rows, unsigned int cols);
+static bool write_all (int fd, const void* buffer, size_t len);
+static bool read_all (int fd, void* buffer, size_t len);
+
+	/*
+		The kernel bodies take the shape as arguments and are always inlined, so the wrappers below that pass constants get loops with
+		fixed trip counts the compiler unrolls, while the innermost loop always runs across matrices and vectorizes.
+	*/
+
+static inline __attribute__((always_inline)) void add_cells (const Batch_Job_t* job, size_t cells, size_t k0, size_t k1) {
+
+	const size_t stride = job->stride;
+	for (size_t e = 0; e < cells; ++e) {
+		const unsigned int* x = job->a + e * stride;
+		const unsigned int* y = job->b + e * stride;
+		unsigned int* z = job->c + e * stride;
+		for (size_t k = k0; k < k1; ++k) {
+			z[k] = x[k] + y[k];
+		}
+	}
+}
+
+static inline __attribute__((always_inline)) void shift_cells (const Batch_Job_t* job, size_t cells, size_t k0, size_t k1) {
+
+	const size_t stride = job->stride;
+	const unsigned int shift = job->shift;
+	for (size_t e = 0; e < cells; ++e) {
+		unsigned int* z = job->c + e * stride;
+		if (shift >= 32) {
+			memset(z + k0, 0, (k1 - k0) * sizeof(unsigned int));
+		}
+		else if (job->direction == 'l') {
+			for (size_t k = k0; k < k1; ++k) z[k] <<= shift;
+		}
+		else {
+			for (size_t k = k0; k < k1; ++k) z[k] >>= shift;
+		}
+	}
+}
+
+static inline __attribute__((always_inline)) void sum_cells (const Batch_Job_t* job, size_t cells, size_t k0, size_t k1) {
+
+	const size_t stride = job->stride;
+	unsigned long long* sums = job->sums;
+	for (size_t k = k0; k < k1; ++k) {
+		sums[k] = 0;
+	}
+	for (size_t e = 0; e < cells; ++e) {
+		const unsigned int* x = job->a + e * stride;
+		for (size_t k = k0; k < k1; ++k) {
+			sums[k] += x[k];
+		}
+	}
+}
+
+static inline __attribute__((always_inline)) void equal_cells (const Batch_Job_t* job, size_t cells, size_t k0, size_t k1) {
+
+	const size_t stride = job->stride;
+	unsigned char* equal = job->equal;
+	for (size_t k = k0; k < k1; ++k) {
+		equal[k] = 1;
+	}
+	for (size_t e = 0; e < cells; ++e) {
+		const unsigned int* x = job->a + e * stride;
+		const unsigned int* y = job->b + e * stride;
+		for (size_t k = k0; k < k1; ++k) {
+			equal[k] &= x[k] == y[k];
+		}
+	}
+}
+
+static inline __attribute__((always_inline)) void multiply_cells (const Batch_Job_t* job, unsigned int rows, unsigned int inner,
+	unsigned int cols, size_t k0, size_t k1) {
+
+	const size_t stride = job->stride;
+	for (unsigned int i = 0; i < rows; ++i) {
+		for (unsigned int j = 0; j < cols; ++j) {
+			unsigned int* restrict z = job->c + ((size_t) i * cols + j) * stride;
+			for (size_t k = k0; k < k1; ++k) {
+				z[k] = 0;
+			}
+			for (unsigned int l = 0; l < inner; ++l) {
+				const unsigned int* restrict x = job->a + ((size_t) i * inner + l) * stride;
+				const unsigned int* restrict y = job->b + ((size_t) l * cols + j) * stride;
+				for (size_t k = k0; k < k1; ++k) {
+					z[k] += x[k] * y[k];
+				}
+			}
+		}
+	}
+}
+
+/* any shape, sizes read from the job */
+static void add_any (const Batch_Job_t* job, size_t k0, size_t k1) { add_cells(job, (size_t) job->rows * job->cols, k0, k1); }
+static void shift_any (const Batch_Job_t* job, size_t k0, size_t k1) { shift_cells(job, (size_t) job->rows * job->cols, k0, k1); }
+static void sum_any (const Batch_Job_t* job, size_t k0, size_t k1) { sum_cells(job, (size_t) job->rows * job->cols, k0, k1); }
+static void equal_any (const Batch_Job_t* job, size_t k0, size_t k1) { equal_cells(job, (size_t) job->rows * job->cols, k0, k1); }
+static void multiply_any (const Batch_Job_t* job, size_t k0, size_t k1) { multiply_cells(job, job->rows, job->inner, job->cols, k0, k1); }
+
+/* N x N, sizes fixed at compile time */
+#define BATCH_SQUARE_KERNELS(N) \
+	static void add_##N (const Batch_Job_t* job, size_t k0, size_t k1) { add_cells(job, N * N, k0, k1); } \
+	static void shift_##N (const Batch_Job_t* job, size_t k0, size_t k1) { shift_cells(job, N * N, k0, k1); } \
+	static void sum_##N (const Batch_Job_t* job, size_t k0, size_t k1) { sum_cells(job, N * N, k0, k1); } \
+	static void equal_##N (const Batch_Job_t* job, size_t k0, size_t k1) { equal_cells(job, N * N, k0, k1); } \
+	static void multiply_##N (const Batch_Job_t* job, size_t k0, size_t k1) { multiply_cells(job, N, N, N, k0, k1); }
+
+#define BATCH_SQUARE_ENTRY(N) [N] = {add_##N, shift_##N, sum_##N, equal_##N, multiply_##N},
+
+#define BATCH_FOR_EACH_SQUARE(X) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) X(16)
+
+BATCH_FOR_EACH_SQUARE(BATCH_SQUARE_KERNELS)
+
+static const Batch_Kernels_t square_kernel_table[BATCH_MAX_SPECIALIZED + 1] = {
+	BATCH_FOR_EACH_SQUARE(BATCH_SQUARE_ENTRY)
+};
+
+static const Batch_Kernels_t any_kernels = {add_any, shift_any, sum_any, equal_any, multiply_any};
+
+	/*
+		PURPOSE: This function creates a batch of count matrices of the same shape, all zero, in two allocations however many matrices it holds.
+		INPUTS: new_batch -> receives the batch. name -> the name of the batch. count -> the number of matrices. rows, cols -> their shape.
+		RETURNS: true on success, false on invalid parameters, a batch too large to address, or when memory ran out.
+	*/
+
+bool create_batch (Matrix_Batch_t** new_batch, const char* name, unsigned int count, unsigned int rows, unsigned int cols) {
+
+	if(!new_batch || !name)
+		return false;
+
+	if(strlen(name) == 0 || strlen(name) + 1 > MATRIX_NAME_LEN)
+		return false;
+
+	if(count == 0 || rows == 0 || cols == 0 || count > 0xFFFFFFFFu - BATCH_LANES)
+		return false;
+
+	/* rows * cols * stride cells must fit in a size_t worth of bytes, a read_batch header can ask for anything */
+	const unsigned int stride = (count + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+	if ((size_t) rows > SIZE_MAX / sizeof(unsigned int) / cols / stride)
+		return false;
+
+	Matrix_Batch_t* b = calloc(1, sizeof(Matrix_Batch_t));
+	if (!b) {
+		return false;
+	}
+	b->count = count;
+	b->stride = stride;
+	b->rows = rows;
+	b->cols = cols;
+	const size_t bytes = (size_t) rows * cols * b->stride * sizeof(unsigned int);
+	void* data = NULL;
+	if (posix_memalign(&data, 64, bytes) != 0) {
+		free(b);
+		return false;
+	}
+	memset(data, 0, bytes);
+	b->data = data;
+	strncpy(b->name, name, MATRIX_NAME_LEN - 1);
+	*new_batch = b;
+	return true;
+}
+
+	/*
+		PURPOSE: This function frees a batch.
+		INPUTS: b -> the batch, set to NULL afterwards.
+		RETURNS: Nothing.
+	*/
+
+void destroy_batch (Matrix_Batch_t** b) {
+
+	if(!b || !(*b))
+		return;
+
+	free((*b)->data);
+	free(*b);
+	*b = NULL;
+}
+
+	/*
+		PURPOSE: This function copies one matrix out of a batch.
+		INPUTS: b -> the batch. index -> which matrix. dest -> receives it, must have the shape of the batch.
+		RETURNS: true on success, false on invalid parameters, an index past the end or mismatched dimensions.
+	*/
+
+bool batch_get_matrix (Matrix_Batch_t* b, unsigned int index, Matrix_t* dest) {
+
+	if(!b || !dest || !dest->data)
+		return false;
+
+	if (index >= b->count || dest->rows != b->rows || dest->cols != b->cols)
+		return false;
+
+	for (unsigned int i = 0; i < b->rows; ++i) {
+		unsigned int changed = 0;
+		for (size_t e = (size_t) i * b->cols; e < (size_t) (i + 1) * b->cols; ++e) {
+			const unsigned int value = b->data[e * b->stride + index];
+			changed |= dest->data[e] ^ value;
+			dest->data[e] = value;
+		}
+		if (changed) {
+			mark_matrix_dirty(dest, i, i + 1);
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function copies a matrix into a batch.
+		INPUTS: b -> the batch. index -> which matrix to replace. src -> the matrix, must have the shape of the batch.
+		RETURNS: true on success, false on invalid parameters, an index past the end or mismatched dimensions.
+	*/
+
+bool batch_set_matrix (Matrix_Batch_t* b, unsigned int index, Matrix_t* src) {
+
+	if(!b || !src || !src->data)
+		return false;
+
+	if (index >= b->count || src->rows != b->rows || src->cols != b->cols)
+		return false;
+
+	const size_t cells = (size_t) b->rows * b->cols;
+	for (size_t e = 0; e < cells; ++e) {
+		b->data[e * b->stride + index] = src->data[e];
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function fills every matrix of a batch with random values like random_matrix.
+		INPUTS: b -> the batch. start_range, end_range -> the inclusive range of the values.
+		RETURNS: true on success, false on invalid parameters.
+	*/
+
+bool random_batch (Matrix_Batch_t* b, unsigned int start_range, unsigned int end_range) {
+
+	if(!b || start_range > end_range)
+		return false;
+
+	const size_t cells = (size_t) b->rows * b->cols;
+	for (size_t e = 0; e < cells; ++e) {
+		unsigned int* plane = &b->data[e * b->stride];
+		for (unsigned int k = 0; k < b->count; ++k) {
+			plane[k] = rand() % (end_range + 1 - start_range) + start_range;
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function adds two batches matrix by matrix, c may be a or b.
+		INPUTS: a, b -> the operands. c -> receives the sums. All three hold as many matrices of the same shape.
+		RETURNS: true on success, false on invalid parameters or mismatched batches.
+	*/
+
+bool add_batches (Matrix_Batch_t* a, Matrix_Batch_t* b, Matrix_Batch_t* c) {
+
+	if(!a || !b || !c)
+		return false;
+
+	if (a->count != b->count || a->count != c->count || a->rows != b->rows || a->cols != b->cols
+		|| a->rows != c->rows || a->cols != c->cols)
+		return false;
+
+	Batch_Job_t job = {0};
+	job.a = a->data;
+	job.b = b->data;
+	job.c = c->data;
+	job.stride = a->stride;
+	job.count = a->count;
+	job.rows = a->rows;
+	job.cols = a->cols;
+	run_batch_job(&job, square_kernels(a->rows, a->cols)->add);
+	return true;
+}
+
+	/*
+		PURPOSE: This function shifts the bits of every cell of every matrix in a batch like bitwise_shift_matrix. Shifting by 32 or more clears
+			the cells.
+		INPUTS: a -> the batch, updated in place. direction -> l or r. shift -> how many bits.
+		RETURNS: true on success, false on invalid parameters.
+	*/
+
+bool shift_batch (Matrix_Batch_t* a, char direction, unsigned int shift) {
+
+	if(!a || (direction != 'l' && direction != 'r'))
+		return false;
+
+	Batch_Job_t job = {0};
+	job.c = a->data;
+	job.stride = a->stride;
+	job.count = a->count;
+	job.rows = a->rows;
+	job.cols = a->cols;
+	job.direction = direction;
+	job.shift = shift;
+	run_batch_job(&job, square_kernels(a->rows, a->cols)->shift);
+	return true;
+}
+
+	/*
+		PURPOSE: This function sums each matrix of a batch.
+		INPUTS: a -> the batch. sums -> room for a->count sums, sums[k] receives the sum of matrix k.
+		RETURNS: true on success, false on invalid parameters.
+	*/
+
+bool sum_batch (Matrix_Batch_t* a, unsigned long long* sums) {
+
+	if(!a || !sums)
+		return false;
+
+	Batch_Job_t job = {0};
+	job.a = a->data;
+	job.stride = a->stride;
+	job.count = a->count;
+	job.rows = a->rows;
+	job.cols = a->cols;
+	job.sums = sums;
+	run_batch_job(&job, square_kernels(a->rows, a->cols)->sum);
+	return true;
+}
+
+	/*
+		PURPOSE: This function compares two batches matrix by matrix.
+		INPUTS: a, b -> the batches. equal -> room for a->count flags, equal[k] is set to 1 if matrix k of a equals matrix k of b, else 0.
+		RETURNS: the number of equal matrices, 0 also on invalid parameters or mismatched batches.
+	*/
+
+unsigned int equal_batches (Matrix_Batch_t* a, Matrix_Batch_t* b, unsigned char* equal) {
+
+	if(!a || !b || !equal)
+		return 0;
+
+	if (a->count != b->count || a->rows != b->rows || a->cols != b->cols)
+		return 0;
+
+	Batch_Job_t job = {0};
+	job.a = a->data;
+	job.b = b->data;
+	job.stride = a->stride;
+	job.count = a->count;
+	job.rows = a->rows;
+	job.cols = a->cols;
+	job.equal = equal;
+	run_batch_job(&job, square_kernels(a->rows, a->cols)->equal);
+
+	unsigned int matches = 0;
+	for (unsigned int k = 0; k < a->count; ++k) {
+		matches += equal[k];
+	}
+	return matches;
+}
+
+	/*
+		PURPOSE: This function multiplies two batches matrix by matrix, c(k) = a(k) * b(k), with arithmetic wrapping like add.
+		INPUTS: a -> rows x n matrices. b -> n x cols matrices. c -> receives the rows x cols products, must not be a or b.
+		RETURNS: true on success, false on invalid parameters, mismatched batches or when c is one of the operands.
+	*/
+
+bool multiply_batches (Matrix_Batch_t* a, Matrix_Batch_t* b, Matrix_Batch_t* c) {
+
+	if(!a || !b || !c || c == a || c == b)
+		return false;
+
+	if (a->count != b->count || a->count != c->count || a->cols != b->rows || c->rows != a->rows || c->cols != b->cols)
+		return false;
+
+	Batch_Job_t job = {0};
+	job.a = a->data;
+	job.b = b->data;
+	job.c = c->data;
+	job.stride = a->stride;
+	job.count = a->count;
+	job.rows = a->rows;
+	job.inner = a->cols;
+	job.cols = b->cols;
+	const bool square = a->rows == a->cols && b->rows == b->cols;
+	run_batch_job(&job, square ? square_kernels(a->rows, a->cols)->multiply : any_kernels.multiply);
+	return true;
+}
+
+	/*
+		PURPOSE: This function writes a batch to a file in its own format: the BATCH_MAGIC tag, the name length and name, count, rows and
+			cols, then every cell plane holding that cell of each matrix, then a final MATRIX_FILE_CLEAN byte. Padding lanes are not written.
+		INPUTS: batch_output_filename -> the file to write. b -> the batch.
+		RETURNS: true on success, false on invalid parameters or an I/O error, in which case the partly written file is removed.
+	*/
+
+bool write_batch (const char* batch_output_filename, Matrix_Batch_t* b) {
+
+	if(!batch_output_filename || strlen(batch_output_filename) == 0)
+		return false;
+
+	if(!b || !b->data)
+		return false;
+
+	int fd = open(batch_output_filename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+
+	const unsigned int name_len = strlen(b->name) + 1;
+	const unsigned char trailer = MATRIX_FILE_CLEAN;
+	const size_t cells = (size_t) b->rows * b->cols;
+	bool ok = write_all(fd, BATCH_MAGIC, BATCH_MAGIC_LEN)
+		&& write_all(fd, &name_len, sizeof(unsigned int))
+		&& write_all(fd, b->name, name_len)
+		&& write_all(fd, &b->count, sizeof(unsigned int))
+		&& write_all(fd, &b->rows, sizeof(unsigned int))
+		&& write_all(fd, &b->cols, sizeof(unsigned int));
+	if (ok && b->count == b->stride) {
+		ok = write_all(fd, b->data, cells * b->stride * sizeof(unsigned int));
+	}
+	else {
+		for (size_t e = 0; ok && e < cells; ++e) {
+			ok = write_all(fd, &b->data[e * b->stride], (size_t) b->count * sizeof(unsigned int));
+		}
+	}
+	ok = ok && write_all(fd, &trailer, sizeof(trailer));
+	if (close(fd)) {
+		ok = false;
+	}
+	if (!ok) {
+		/* a partial file would only be rejected when read back */
+		unlink(batch_output_filename);
+	}
+	return ok;
+}
+
+	/*
+		PURPOSE: This function reads a batch written by write_batch.
+		INPUTS: batch_input_filename -> the file to read. b -> receives the new batch.
+		RETURNS: true on success, false on invalid parameters, an I/O error, a file that is not a batch file or one whose MATRIX_FILE_CLEAN
+			trailer is missing because the write did not finish.
+	*/
+
+bool read_batch (const char* batch_input_filename, Matrix_Batch_t** b) {
+
+	if(!batch_input_filename || strlen(batch_input_filename) == 0)
+		return false;
+
+	if(!b)
+		return false;
+
+	int fd = open(batch_input_filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	char magic[BATCH_MAGIC_LEN];
+	unsigned int name_len = 0;
+	char name[MATRIX_NAME_LEN];
+	unsigned int count = 0;
+	unsigned int rows = 0;
+	unsigned int cols = 0;
+	if (!read_all(fd, magic, sizeof(magic)) || memcmp(magic, BATCH_MAGIC, BATCH_MAGIC_LEN) != 0
+		|| !read_all(fd, &name_len, sizeof(unsigned int)) || name_len == 0 || name_len > MATRIX_NAME_LEN
+		|| !read_all(fd, name, name_len)
+		|| !read_all(fd, &count, sizeof(unsigned int)) || !read_all(fd, &rows, sizeof(unsigned int))
+		|| !read_all(fd, &cols, sizeof(unsigned int))) {
+		close(fd);
+		return false;
+	}
+	name[name_len - 1] = '\0';
+
+	if (!create_batch(b, name, count, rows, cols)) {
+		close(fd);
+		return false;
+	}
+	const size_t cells = (size_t) rows * cols;
+	bool ok = true;
+	if ((*b)->count == (*b)->stride) {
+		ok = read_all(fd, (*b)->data, cells * (*b)->stride * sizeof(unsigned int));
+	}
+	else {
+		for (size_t e = 0; ok && e < cells; ++e) {
+			ok = read_all(fd, &(*b)->data[e * (*b)->stride], (size_t) count * sizeof(unsigned int));
+		}
+	}
+	unsigned char trailer = MATRIX_FILE_UPDATING;
+	ok = ok && read_all(fd, &trailer, sizeof(trailer)) && trailer == MATRIX_FILE_CLEAN;
+	close(fd);
+	if (!ok) {
+		destroy_batch(b);
+		return false;
+	}
+	return true;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function runs a batch kernel with the matrices split between workers in groups of BATCH_LANES, so every worker
+			touches whole cache lines of each cell plane.
+		INPUTS: job -> the operands. kernel -> the kernel to run.
+		RETURNS: Nothing.
+	*/
+
+static void run_batch_job (Batch_Job_t* job, Batch_Kernel_t kernel) {
+
+	job->kernel = kernel;
+	const unsigned int groups = job->stride / BATCH_LANES;
+	/* multiply does inner times the work per output cell; past enough work for every worker the exact figure does not matter */
+	unsigned long long cells_per_group = (unsigned long long) job->rows * (job->inner ? job->inner : 1) * job->cols * BATCH_LANES;
+	if (cells_per_group > (unsigned long long) PARALLEL_MIN_CELLS * PARALLEL_MAX_WORKERS) {
+		cells_per_group = (unsigned long long) PARALLEL_MIN_CELLS * PARALLEL_MAX_WORKERS;
+	}
+	parallel_for_rows(groups, (unsigned int) cells_per_group, batch_lane_range, job);
+}
+
+	/*
+		PURPOSE: This function is the per worker body of the batch kernels, it runs the kernel over the matrices of its lane groups.
+		INPUTS: first_group, end_group -> the groups of BATCH_LANES matrices. worker -> unused. arg -> the Batch_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void batch_lane_range (unsigned int first_group, unsigned int end_group, unsigned int worker, void* arg) {
+
+	Batch_Job_t* job = arg;
+	const size_t first_lane = (size_t) first_group * BATCH_LANES;
+	size_t end_lane = (size_t) end_group * BATCH_LANES;
+	if (end_lane > job->count) {
+		end_lane = job->count;
+	}
+	if (first_lane < end_lane) {
+		job->kernel(job, first_lane, end_lane);
+	}
+}
+
+	/*
+		PURPOSE: This function picks the kernels for a shape, the compile time specialized ones for square shapes they exist for.
+		INPUTS: rows, cols -> the shape of the matrices.
+		RETURNS: the kernels to use.
+	*/
+
+static const Batch_Kernels_t* square_kernels (unsigned int rows, unsigned int cols) {
+
+	if (rows == cols && rows >= 2 && rows <= BATCH_MAX_SPECIALIZED) {
+		return &square_kernel_table[rows];
+	}
+	return &any_kernels;
+}
+
+	/*
+		PURPOSE: This function writes a whole buffer, resuming after short writes.
+		INPUTS: fd -> the file. buffer, len -> the bytes to write.
+		RETURNS: true if everything was written.
+	*/
+
+static bool write_all (int fd, const void* buffer, size_t len) {
+
+	const unsigned char* p = buffer;
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function reads a whole buffer, resuming after short reads.
+		INPUTS: fd -> the file. buffer, len -> where the bytes go and how many.
+		RETURNS: true if everything was read, false on an error or end of file.
+	*/
+
+static bool read_all (int fd, void* buffer, size_t len) {
+
+	unsigned char* p = buffer;
+	while (len > 0) {
+		ssize_t n = read(fd, p, len);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
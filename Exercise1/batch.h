@@ -0,0 +1,36 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include "matrix.h"
+
+/* the matrix count is padded to a multiple of this so every cell plane starts on a 64 byte boundary */
+#define BATCH_LANES 16
+/* square shapes from 2x2 up to this size get kernels with the shape fixed at compile time */
+#define BATCH_MAX_SPECIALIZED 16
+#define BATCH_MAGIC "MATBAT01"
+#define BATCH_MAGIC_LEN 8
+
+/* cell (i,j) of matrix k is data[(i * cols + j) * stride + k], the same cell of every matrix is contiguous so kernels run across matrices */
+typedef struct {
+	char name[MATRIX_NAME_LEN];
+	unsigned int count;
+	unsigned int stride;
+	unsigned int rows;
+	unsigned int cols;
+	unsigned int* data;
+}Matrix_Batch_t;
+
+bool create_batch (Matrix_Batch_t** new_batch, const char* name, unsigned int count, unsigned int rows, unsigned int cols);
+void destroy_batch (Matrix_Batch_t** b);
+bool batch_get_matrix (Matrix_Batch_t* b, unsigned int index, Matrix_t* dest);
+bool batch_set_matrix (Matrix_Batch_t* b, unsigned int index, Matrix_t* src);
+bool random_batch (Matrix_Batch_t* b, unsigned int start_range, unsigned int end_range);
+bool add_batches (Matrix_Batch_t* a, Matrix_Batch_t* b, Matrix_Batch_t* c);
+bool shift_batch (Matrix_Batch_t* a, char direction, unsigned int shift);
+bool sum_batch (Matrix_Batch_t* a, unsigned long long* sums);
+unsigned int equal_batches (Matrix_Batch_t* a, Matrix_Batch_t* b, unsigned char* equal);
+bool multiply_batches (Matrix_Batch_t* a, Matrix_Batch_t* b, Matrix_Batch_t* c);
+bool write_batch (const char* batch_output_filename, Matrix_Batch_t* b);
+bool read_batch (const char* batch_input_filename, Matrix_Batch_t** b);
+
+#endif
@@ -0,0 +1,536 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "bitmatrix.h"
+#include "parallel.h"
+
+/* use the popcnt instruction where the CPU has it, picked once at load time */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define POPCOUNT_CLONES __attribute__((target_clones("popcnt", "default")))
+#else
+#define POPCOUNT_CLONES
+#endif
+
+typedef struct {
+	const Bit_Matrix_t* a;
+	const Bit_Matrix_t* b;
+	Bit_Matrix_t* c;
+}Bit_Multiply_Job_t;
+
+/*protected functions*/
+static unsigned long long last_word_mask (const Bit_Matrix_t* m);
+static unsigned long long count_row (const unsigned long long* row, unsigned int words);
+static void multiply_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+static bool write_all (int fd, const void* buffer, size_t len);
+static bool read_all (int fd, void* buffer, size_t len);
+
+	/*
+		PURPOSE: instantiates a new bit matrix with every cell cleared.
+		INPUTS: new_matrix -> receives the matrix. name -> the name of the matrix. rows, cols -> the dimensions of the matrix.
+		RETURNS: true on success, false on invalid parameters or when memory ran out.
+	*/
+
+bool create_bit_matrix (Bit_Matrix_t** new_matrix, const char* name, const unsigned int rows, const unsigned int cols) {
+
+	if(!new_matrix || !name)
+		return false;
+
+	if(strlen(name) == 0 || strlen(name) + 1 > MATRIX_NAME_LEN)
+		return false;
+
+	if(rows == 0 || cols == 0)
+		return false;
+
+	Bit_Matrix_t* m = calloc(1, sizeof(Bit_Matrix_t));
+	if (!m) {
+		return false;
+	}
+	m->rows = rows;
+	m->cols = cols;
+	m->words_per_row = (cols + BIT_MATRIX_WORD_BITS - 1) / BIT_MATRIX_WORD_BITS;
+	m->words = calloc((size_t) rows * m->words_per_row, sizeof(unsigned long long));
+	if (!m->words) {
+		free(m);
+		return false;
+	}
+	strncpy(m->name, name, MATRIX_NAME_LEN - 1);
+	*new_matrix = m;
+	return true;
+}
+
+	/*
+		PURPOSE: This function frees a bit matrix.
+		INPUTS: m -> the matrix, set to NULL afterwards.
+		RETURNS: Nothing.
+	*/
+
+void destroy_bit_matrix (Bit_Matrix_t** m) {
+
+	if(!m || !(*m))
+		return;
+
+	free((*m)->words);
+	free(*m);
+	*m = NULL;
+}
+
+	/*
+		PURPOSE: This function converts a dense matrix into a bit matrix of the same dimensions, every non zero cell becomes a set bit.
+		INPUTS: src -> the dense matrix. dest -> the bit matrix, overwritten.
+		RETURNS: true on success, false on invalid parameters or mismatched dimensions.
+	*/
+
+bool pack_matrix (Matrix_t* src, Bit_Matrix_t* dest) {
+
+	if(!src || !dest || !src->data || !dest->words)
+		return false;
+
+	if (src->rows != dest->rows || src->cols != dest->cols)
+		return false;
+
+	for (unsigned int i = 0; i < src->rows; ++i) {
+		const unsigned int* cells = &src->data[(size_t) i * src->cols];
+		unsigned long long* row = &dest->words[(size_t) i * dest->words_per_row];
+		for (unsigned int w = 0; w < dest->words_per_row; ++w) {
+			const unsigned int first = w * BIT_MATRIX_WORD_BITS;
+			const unsigned int count = src->cols - first < BIT_MATRIX_WORD_BITS ? src->cols - first : BIT_MATRIX_WORD_BITS;
+			unsigned long long word = 0;
+			for (unsigned int b = 0; b < count; ++b) {
+				word |= (unsigned long long) (cells[first + b] != 0) << b;
+			}
+			row[w] = word;
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function converts a bit matrix into a dense matrix of the same dimensions holding 0 and 1.
+		INPUTS: src -> the bit matrix. dest -> the dense matrix, overwritten.
+		RETURNS: true on success, false on invalid parameters or mismatched dimensions.
+	*/
+
+bool unpack_bit_matrix (Bit_Matrix_t* src, Matrix_t* dest) {
+
+	if(!src || !dest || !src->words || !dest->data)
+		return false;
+
+	if (src->rows != dest->rows || src->cols != dest->cols)
+		return false;
+
+	for (unsigned int i = 0; i < src->rows; ++i) {
+		const unsigned long long* row = &src->words[(size_t) i * src->words_per_row];
+		unsigned int* cells = &dest->data[(size_t) i * dest->cols];
+		unsigned int changed = 0;
+		for (unsigned int j = 0; j < dest->cols; ++j) {
+			const unsigned int bit = (row[j / BIT_MATRIX_WORD_BITS] >> (j % BIT_MATRIX_WORD_BITS)) & 1;
+			changed |= cells[j] ^ bit;
+			cells[j] = bit;
+		}
+		if (changed) {
+			mark_matrix_dirty(dest, i, i + 1);
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function combines two bit matrices cell by cell, 64 cells per word operation, and stores the result in a third one.
+			c may be the same matrix as a or b.
+		INPUTS: a, b -> the operands. c -> receives the result. op -> MATRIX_OP_AND, MATRIX_OP_OR or MATRIX_OP_XOR.
+		RETURNS: true on success, false on invalid parameters, mismatched dimensions or an unsupported operation.
+	*/
+
+bool bitwise_bit_matrices (Bit_Matrix_t* a, Bit_Matrix_t* b, Bit_Matrix_t* c, Matrix_Op_t op) {
+
+	if(!a || !b || !c || !a->words || !b->words || !c->words)
+		return false;
+
+	if (a->rows != b->rows || a->cols != b->cols || a->rows != c->rows || a->cols != c->cols)
+		return false;
+
+	const size_t n = (size_t) a->rows * a->words_per_row;
+	const unsigned long long* x = a->words;
+	const unsigned long long* y = b->words;
+	unsigned long long* z = c->words;
+	switch (op) {
+		case MATRIX_OP_AND:
+			for (size_t i = 0; i < n; ++i) z[i] = x[i] & y[i];
+			break;
+		case MATRIX_OP_OR:
+			for (size_t i = 0; i < n; ++i) z[i] = x[i] | y[i];
+			break;
+		case MATRIX_OP_XOR:
+			for (size_t i = 0; i < n; ++i) z[i] = x[i] ^ y[i];
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function flips every cell of a bit matrix, keeping the padding bits past the last column clear.
+		INPUTS: a -> the matrix, updated in place.
+		RETURNS: true on success, false on invalid parameters.
+	*/
+
+bool not_bit_matrix (Bit_Matrix_t* a) {
+
+	if(!a || !a->words)
+		return false;
+
+	const size_t n = (size_t) a->rows * a->words_per_row;
+	for (size_t i = 0; i < n; ++i) {
+		a->words[i] = ~a->words[i];
+	}
+	const unsigned long long mask = last_word_mask(a);
+	for (unsigned int i = 0; i < a->rows; ++i) {
+		a->words[(size_t) i * a->words_per_row + a->words_per_row - 1] &= mask;
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function counts the set cells of a bit matrix with a population count per word.
+		INPUTS: a -> the matrix. row_counts -> if not NULL, room for a->rows counts that receive the set cells of each row.
+		RETURNS: the number of set cells, 0 on invalid parameters.
+	*/
+
+unsigned long long count_bit_matrix (Bit_Matrix_t* a, unsigned int* row_counts) {
+
+	if(!a || !a->words)
+		return 0;
+
+	unsigned long long total = 0;
+	for (unsigned int i = 0; i < a->rows; ++i) {
+		const unsigned long long count = count_row(&a->words[(size_t) i * a->words_per_row], a->words_per_row);
+		if (row_counts) {
+			row_counts[i] = (unsigned int) count;
+		}
+		total += count;
+	}
+	return total;
+}
+
+	/*
+		PURPOSE: This function moves the cells of a bit matrix, filling vacated cells with zeros. 'l' and 'r' move cells along the rows
+			towards lower and higher columns, 'u' and 'd' move whole rows towards lower and higher row indices.
+		INPUTS: a -> the matrix, updated in place. direction -> one of l, r, u, d. shift -> how many cells to move by.
+		RETURNS: true on success, false on invalid parameters.
+	*/
+
+bool shift_bit_matrix (Bit_Matrix_t* a, char direction, unsigned int shift) {
+
+	if(!a || !a->words)
+		return false;
+
+	const unsigned int wpr = a->words_per_row;
+	const size_t row_bytes = (size_t) wpr * sizeof(unsigned long long);
+
+	if (direction == 'u' || direction == 'd') {
+		if (shift >= a->rows) {
+			memset(a->words, 0, row_bytes * a->rows);
+			return true;
+		}
+		const size_t moved = row_bytes * (a->rows - shift);
+		if (direction == 'u') {
+			memmove(a->words, &a->words[(size_t) shift * wpr], moved);
+			memset(&a->words[(size_t) (a->rows - shift) * wpr], 0, row_bytes * shift);
+		}
+		else {
+			memmove(&a->words[(size_t) shift * wpr], a->words, moved);
+			memset(a->words, 0, row_bytes * shift);
+		}
+		return true;
+	}
+
+	if (direction != 'l' && direction != 'r')
+		return false;
+
+	if (shift >= a->cols) {
+		memset(a->words, 0, row_bytes * a->rows);
+		return true;
+	}
+
+	const unsigned int word_shift = shift / BIT_MATRIX_WORD_BITS;
+	const unsigned int bit_shift = shift % BIT_MATRIX_WORD_BITS;
+	const unsigned long long mask = last_word_mask(a);
+	for (unsigned int i = 0; i < a->rows; ++i) {
+		unsigned long long* row = &a->words[(size_t) i * wpr];
+		if (direction == 'l') {
+			/* column j takes column j + shift, a right shift of the row read as one wide integer */
+			for (unsigned int w = 0; w < wpr; ++w) {
+				const unsigned long long lo = w + word_shift < wpr ? row[w + word_shift] : 0;
+				const unsigned long long hi = w + word_shift + 1 < wpr ? row[w + word_shift + 1] : 0;
+				row[w] = bit_shift ? (lo >> bit_shift) | (hi << (BIT_MATRIX_WORD_BITS - bit_shift)) : lo;
+			}
+		}
+		else {
+			for (unsigned int w = wpr; w-- > 0; ) {
+				const unsigned long long hi = w >= word_shift ? row[w - word_shift] : 0;
+				const unsigned long long lo = w >= word_shift + 1 ? row[w - word_shift - 1] : 0;
+				row[w] = bit_shift ? (hi << bit_shift) | (lo >> (BIT_MATRIX_WORD_BITS - bit_shift)) : hi;
+			}
+			row[wpr - 1] &= mask;
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function computes the boolean matrix product c = a * b, where c(i,j) is set when some k has a(i,k) and b(k,j) set.
+			Row i of c is the OR of the rows of b selected by the set bits of row i of a, so the inner loop works on whole words of b.
+			Rows of a are split across workers.
+		INPUTS: a -> the left operand, rows x n. b -> the right operand, n x cols. c -> receives the rows x cols result, must not be a or b.
+		RETURNS: true on success, false on invalid parameters, mismatched dimensions or when c aliases an operand.
+	*/
+
+bool multiply_bit_matrices (Bit_Matrix_t* a, Bit_Matrix_t* b, Bit_Matrix_t* c) {
+
+	if(!a || !b || !c || !a->words || !b->words || !c->words)
+		return false;
+
+	if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols || c == a || c == b)
+		return false;
+
+	Bit_Multiply_Job_t job = {a, b, c};
+	parallel_for_rows(a->rows, b->words_per_row * BIT_MATRIX_WORD_BITS, multiply_row_range, &job);
+	return true;
+}
+
+	/*
+		PURPOSE: This function writes a bit matrix to a file in its own format: the BIT_MATRIX_MAGIC tag, the name length and name, rows,
+			cols and words per row, the packed words and a final MATRIX_FILE_CLEAN byte. The tag keeps it apart from dense matrix files.
+		INPUTS: bit_matrix_output_filename -> the file to write. m -> the matrix.
+		RETURNS: true on success, false on invalid parameters or an I/O error, in which case the partly written file is removed.
+	*/
+
+bool write_bit_matrix (const char* bit_matrix_output_filename, Bit_Matrix_t* m) {
+
+	if(!bit_matrix_output_filename || strlen(bit_matrix_output_filename) == 0)
+		return false;
+
+	if(!m || !m->words)
+		return false;
+
+	int fd = open(bit_matrix_output_filename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+
+	const unsigned int name_len = strlen(m->name) + 1;
+	const unsigned char trailer = MATRIX_FILE_CLEAN;
+	bool ok = write_all(fd, BIT_MATRIX_MAGIC, BIT_MATRIX_MAGIC_LEN)
+		&& write_all(fd, &name_len, sizeof(unsigned int))
+		&& write_all(fd, m->name, name_len)
+		&& write_all(fd, &m->rows, sizeof(unsigned int))
+		&& write_all(fd, &m->cols, sizeof(unsigned int))
+		&& write_all(fd, &m->words_per_row, sizeof(unsigned int))
+		&& write_all(fd, m->words, (size_t) m->rows * m->words_per_row * sizeof(unsigned long long))
+		&& write_all(fd, &trailer, sizeof(trailer));
+	if (close(fd)) {
+		ok = false;
+	}
+	if (!ok) {
+		/* a partial file would only be rejected when read back */
+		unlink(bit_matrix_output_filename);
+	}
+	return ok;
+}
+
+	/*
+		PURPOSE: This function reads a bit matrix written by write_bit_matrix. The kernels count on the padding bits past cols in the last word
+			of every row being clear, so a file with any of them set is refused rather than trusted.
+		INPUTS: bit_matrix_input_filename -> the file to read. m -> receives the new matrix.
+		RETURNS: true on success, false on invalid parameters, an I/O error, a file that is not a bit matrix file, one with padding bits
+			set, or one whose MATRIX_FILE_CLEAN trailer is missing because the write did not finish.
+	*/
+
+bool read_bit_matrix (const char* bit_matrix_input_filename, Bit_Matrix_t** m) {
+
+	if(!bit_matrix_input_filename || strlen(bit_matrix_input_filename) == 0)
+		return false;
+
+	if(!m)
+		return false;
+
+	int fd = open(bit_matrix_input_filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	char magic[BIT_MATRIX_MAGIC_LEN];
+	unsigned int name_len = 0;
+	char name[MATRIX_NAME_LEN];
+	unsigned int rows = 0;
+	unsigned int cols = 0;
+	unsigned int words_per_row = 0;
+	if (!read_all(fd, magic, sizeof(magic)) || memcmp(magic, BIT_MATRIX_MAGIC, BIT_MATRIX_MAGIC_LEN) != 0
+		|| !read_all(fd, &name_len, sizeof(unsigned int)) || name_len == 0 || name_len > MATRIX_NAME_LEN
+		|| !read_all(fd, name, name_len)
+		|| !read_all(fd, &rows, sizeof(unsigned int)) || !read_all(fd, &cols, sizeof(unsigned int))
+		|| !read_all(fd, &words_per_row, sizeof(unsigned int))) {
+		close(fd);
+		return false;
+	}
+	name[name_len - 1] = '\0';
+
+	if (!create_bit_matrix(m, name, rows, cols) || (*m)->words_per_row != words_per_row) {
+		destroy_bit_matrix(m);
+		close(fd);
+		return false;
+	}
+	unsigned char trailer = MATRIX_FILE_UPDATING;
+	bool ok = read_all(fd, (*m)->words, (size_t) rows * words_per_row * sizeof(unsigned long long))
+		&& read_all(fd, &trailer, sizeof(trailer)) && trailer == MATRIX_FILE_CLEAN;
+	close(fd);
+
+	const unsigned long long padding = ~last_word_mask(*m);
+	for (unsigned int i = 0; ok && i < rows; ++i) {
+		ok = ((*m)->words[(size_t) i * words_per_row + words_per_row - 1] & padding) == 0;
+	}
+	if (!ok) {
+		destroy_bit_matrix(m);
+		return false;
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function prints a bit matrix as rows of 0 and 1.
+		INPUTS: out -> the stream to print to. m -> the matrix to print.
+		RETURNS: Nothing.
+	*/
+
+void print_bit_matrix (FILE* out, Bit_Matrix_t* m) {
+
+	if(!out || !m || !m->words)
+		return;
+
+	fprintf(out, "\nBit Matrix Contents (%s):\n", m->name);
+	fprintf(out, "DIM = (%u,%u)\n", m->rows, m->cols);
+	for (unsigned int i = 0; i < m->rows; ++i) {
+		const unsigned long long* row = &m->words[(size_t) i * m->words_per_row];
+		for (unsigned int j = 0; j < m->cols; ++j) {
+			fputc((row[j / BIT_MATRIX_WORD_BITS] >> (j % BIT_MATRIX_WORD_BITS)) & 1 ? '1' : '0', out);
+		}
+		fprintf(out, "\n");
+	}
+	fprintf(out, "\n");
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function builds the mask of the bits of the last word of a row that hold cells.
+		INPUTS: m -> the matrix.
+		RETURNS: the mask, all ones when cols is a multiple of 64.
+	*/
+
+static unsigned long long last_word_mask (const Bit_Matrix_t* m) {
+
+	const unsigned int used = m->cols % BIT_MATRIX_WORD_BITS;
+	return used ? (1ULL << used) - 1 : ~0ULL;
+}
+
+	/*
+		PURPOSE: This function counts the set bits of a row of words.
+		INPUTS: row -> the words. words -> how many words.
+		RETURNS: the number of set bits.
+	*/
+
+POPCOUNT_CLONES
+static unsigned long long count_row (const unsigned long long* row, unsigned int words) {
+
+	unsigned long long count = 0;
+	for (unsigned int w = 0; w < words; ++w) {
+		count += __builtin_popcountll(row[w]);
+	}
+	return count;
+}
+
+	/*
+		PURPOSE: This function is the per worker body of multiply_bit_matrices.
+		INPUTS: first_row, end_row -> the rows of a and c to process. worker -> unused. arg -> the Bit_Multiply_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void multiply_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Bit_Multiply_Job_t* job = arg;
+	const Bit_Matrix_t* a = job->a;
+	const Bit_Matrix_t* b = job->b;
+	const unsigned int wpr = b->words_per_row;
+
+	for (unsigned int i = first_row; i < end_row; ++i) {
+		unsigned long long* out = &job->c->words[(size_t) i * wpr];
+		memset(out, 0, wpr * sizeof(unsigned long long));
+		const unsigned long long* selector = &a->words[(size_t) i * a->words_per_row];
+		for (unsigned int w = 0; w < a->words_per_row; ++w) {
+			unsigned long long bits = selector[w];
+			while (bits) {
+				const unsigned int k = w * BIT_MATRIX_WORD_BITS + __builtin_ctzll(bits);
+				const unsigned long long* in = &b->words[(size_t) k * wpr];
+				for (unsigned int j = 0; j < wpr; ++j) {
+					out[j] |= in[j];
+				}
+				bits &= bits - 1;
+			}
+		}
+	}
+}
+
+	/*
+		PURPOSE: This function writes a whole buffer, resuming after short writes.
+		INPUTS: fd -> the file. buffer, len -> the bytes to write.
+		RETURNS: true if everything was written.
+	*/
+
+static bool write_all (int fd, const void* buffer, size_t len) {
+
+	const unsigned char* p = buffer;
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function reads a whole buffer, resuming after short reads.
+		INPUTS: fd -> the file. buffer, len -> where the bytes go and how many.
+		RETURNS: true if everything was read, false on an error or end of file.
+	*/
+
+static bool read_all (int fd, void* buffer, size_t len) {
+
+	unsigned char* p = buffer;
+	while (len > 0) {
+		ssize_t n = read(fd, p, len);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
@@ -0,0 +1,32 @@
+#ifndef _BITMATRIX_H_
+#define _BITMATRIX_H_
+
+#include "matrix.h"
+
+#define BIT_MATRIX_MAGIC "BITMAT01"
+#define BIT_MATRIX_MAGIC_LEN 8
+#define BIT_MATRIX_WORD_BITS 64
+
+/* 64 cells per word, cell (i,j) is bit j % 64 of word j / 64 of row i; bits past cols are always zero */
+typedef struct {
+	char name[MATRIX_NAME_LEN];
+	unsigned int rows;
+	unsigned int cols;
+	unsigned int words_per_row;
+	unsigned long long* words;
+}Bit_Matrix_t;
+
+bool create_bit_matrix (Bit_Matrix_t** new_matrix, const char* name, const unsigned int rows, const unsigned int cols);
+void destroy_bit_matrix (Bit_Matrix_t** m);
+bool pack_matrix (Matrix_t* src, Bit_Matrix_t* dest);
+bool unpack_bit_matrix (Bit_Matrix_t* src, Matrix_t* dest);
+bool bitwise_bit_matrices (Bit_Matrix_t* a, Bit_Matrix_t* b, Bit_Matrix_t* c, Matrix_Op_t op);
+bool not_bit_matrix (Bit_Matrix_t* a);
+unsigned long long count_bit_matrix (Bit_Matrix_t* a, unsigned int* row_counts);
+bool shift_bit_matrix (Bit_Matrix_t* a, char direction, unsigned int shift);
+bool multiply_bit_matrices (Bit_Matrix_t* a, Bit_Matrix_t* b, Bit_Matrix_t* c);
+bool write_bit_matrix (const char* bit_matrix_output_filename, Bit_Matrix_t* m);
+bool read_bit_matrix (const char* bit_matrix_input_filename, Bit_Matrix_t** m);
+void print_bit_matrix (FILE* out, Bit_Matrix_t* m);
+
+#endif
@@ -12,7 +12,8 @@
 		PURPOSE: This function takes in the user input, and parses it out into an array of commands to be executed by the program. 
 		INPUTS: It takes in an input string, that is the command, such as 'create test 4 4' and a cmd structure pointer that holds a num_cmds variable
 			and a cmds array pointed to by a double pointer. 
-		RETURNS: This function returns false at any point if anything fails, such as the input being null, or if the entire sturucture pointer is null
+		RETURNS: This function returns false at any point if anything fails, such as the input being null, if the entire sturucture pointer is null
+			or if a word is longer than MAX_CMD_LEN - 1 characters
 	*/
 
 bool parse_user_input (const char* input, Commands_t** cmd) {
@@ -36,12 +37,25 @@ bool parse_user_input (const char* input, Commands_t** cmd) {
 	char *token;
 	token = strtok(string, " \n");
 	for (; token != NULL && i < MAX_CMD_COUNT; ++i) {
+		const size_t len = strlen(token);
+		if (len >= MAX_CMD_LEN) {
+			printf("Please try again, \"%s\" is longer than %d characters.\n", token, MAX_CMD_LEN - 1);
+			for (unsigned int j = 0; j < i; ++j) {
+				free((*cmd)->cmds[j]);
+			}
+			free((*cmd)->cmds);
+			free(*cmd);
+			*cmd = NULL;
+			free(string);
+			return false;
+		}
 		(*cmd)->cmds[i] = calloc(MAX_CMD_LEN,sizeof(char));
 		if (!(*cmd)->cmds[i]) {
 			perror("Allocation Error\n");
 			return false;
 		}	
-		strncpy((*cmd)->cmds[i],token, strlen(token) + 1);
+		memcpy((*cmd)->cmds[i], token, len);
+		(*cmd)->cmds[i][len] = '\0';
 		(*cmd)->num_cmds++;
 		token = strtok(NULL, " \n");
 	}
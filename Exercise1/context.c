@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "context.h"
+
+/*protected functions*/
+static int find_slot (Matrix_Context_t* ctx, const char* name);
+
+	/*
+		PURPOSE: This function creates an empty table of matrices. Everything the matrix code keeps between calls lives in a context, so any
+			number of them can be used side by side, each shared by any number of threads.
+		INPUTS: ctx -> receives the new context. num_mats -> how many matrices it holds before the oldest slot is reused.
+		RETURNS: MATRIX_OK on success, MATRIX_ERR_ARGS on invalid parameters or MATRIX_ERR_NO_MEMORY when memory ran out.
+	*/
+
+Matrix_Status_t create_matrix_context (Matrix_Context_t** ctx, unsigned int num_mats) {
+
+	if(!ctx || num_mats == 0)
+		return MATRIX_ERR_ARGS;
+
+	Matrix_Context_t* c = calloc(1, sizeof(Matrix_Context_t));
+	if (!c) {
+		return MATRIX_ERR_NO_MEMORY;
+	}
+	c->mats = calloc(num_mats, sizeof(Matrix_t*));
+	if (!c->mats || pthread_mutex_init(&c->lock, NULL)) {
+		free(c->mats);
+		free(c);
+		return MATRIX_ERR_NO_MEMORY;
+	}
+	c->num_mats = num_mats;
+	*ctx = c;
+	return MATRIX_OK;
+}
+
+	/*
+		PURPOSE: This function destroys a context and every matrix still in it. No other thread may be using the context.
+		INPUTS: ctx -> the context, set to NULL.
+		RETURNS: Nothing.
+	*/
+
+void destroy_matrix_context (Matrix_Context_t** ctx) {
+
+	if(!ctx || !(*ctx))
+		return;
+
+	for (unsigned int i = 0; i < (*ctx)->num_mats; ++i) {
+		destroy_matrix(&(*ctx)->mats[i]);
+	}
+	pthread_mutex_destroy(&(*ctx)->lock);
+	free((*ctx)->mats);
+	free(*ctx);
+	*ctx = NULL;
+}
+
+	/*
+		PURPOSE: This function hands a matrix to a context. It goes in the next slot in turn, and whatever matrix held that slot is destroyed,
+			so a matrix found in the context must not be used by one thread while another adds to it; take it out instead.
+		INPUTS: ctx -> the context. new_matrix -> the matrix, owned by the context from now on. slot -> NULL, or receives the slot used.
+		RETURNS: MATRIX_OK on success or MATRIX_ERR_ARGS on invalid parameters, the context does not take the matrix then.
+	*/
+
+Matrix_Status_t context_add_matrix (Matrix_Context_t* ctx, Matrix_t* new_matrix, unsigned int* slot) {
+
+	if(!ctx || !new_matrix)
+		return MATRIX_ERR_ARGS;
+
+	pthread_mutex_lock(&ctx->lock);
+	const unsigned int pos = ctx->next_slot % ctx->num_mats;
+	Matrix_t* evicted = ctx->mats[pos];
+	ctx->mats[pos] = new_matrix;
+	ctx->next_slot++;
+	pthread_mutex_unlock(&ctx->lock);
+
+	destroy_matrix(&evicted);
+	if (slot) {
+		*slot = pos;
+	}
+	return MATRIX_OK;
+}
+
+	/*
+		PURPOSE: This function hands a matrix to a context like context_add_matrix, but at a position handed out ahead of time instead of the
+			next one in turn, so adds that finish in any order still fill the slots in the order the positions were handed out. A caller
+			handing out positions starts from next_slot and gives each one out once. next_slot moves past the position if it is not already.
+		INPUTS: ctx -> the context. new_matrix -> the matrix, owned by the context from now on. position -> which add this is, counted like
+			next_slot; the matrix goes to slot position % num_mats and whatever held that slot is destroyed. slot -> NULL, or receives the slot.
+		RETURNS: MATRIX_OK on success or MATRIX_ERR_ARGS on invalid parameters, the context does not take the matrix then.
+	*/
+
+Matrix_Status_t context_add_matrix_at (Matrix_Context_t* ctx, Matrix_t* new_matrix, unsigned long long position, unsigned int* slot) {
+
+	if(!ctx || !new_matrix)
+		return MATRIX_ERR_ARGS;
+
+	pthread_mutex_lock(&ctx->lock);
+	const unsigned int pos = position % ctx->num_mats;
+	Matrix_t* evicted = ctx->mats[pos];
+	ctx->mats[pos] = new_matrix;
+	if (ctx->next_slot <= position) {
+		ctx->next_slot = position + 1;
+	}
+	pthread_mutex_unlock(&ctx->lock);
+
+	destroy_matrix(&evicted);
+	if (slot) {
+		*slot = pos;
+	}
+	return MATRIX_OK;
+}
+
+	/*
+		PURPOSE: This function looks up a matrix by name. The context keeps the matrix and the pointer is only borrowed: the next add that
+			reuses its slot destroys it, so this must not be called while another thread may add to the context (context_add_matrix,
+			load_session). Threads sharing a context use context_copy_matrix or context_take_matrix instead.
+		INPUTS: ctx -> the context. name -> the name to look for. m -> receives the first matrix with that name.
+		RETURNS: MATRIX_OK when one was found, MATRIX_ERR_NOT_FOUND when none was, or MATRIX_ERR_ARGS on invalid parameters.
+	*/
+
+Matrix_Status_t context_find_matrix (Matrix_Context_t* ctx, const char* name, Matrix_t** m) {
+
+	if(!ctx || !name || !m)
+		return MATRIX_ERR_ARGS;
+
+	pthread_mutex_lock(&ctx->lock);
+	const int pos = find_slot(ctx, name);
+	if (pos >= 0) {
+		*m = ctx->mats[pos];
+	}
+	pthread_mutex_unlock(&ctx->lock);
+	return pos >= 0 ? MATRIX_OK : MATRIX_ERR_NOT_FOUND;
+}
+
+	/*
+		PURPOSE: This function removes a matrix from a context and gives it to the caller, who can then use it from any one thread without
+			holding anything and must destroy it, or add it back, when done.
+		INPUTS: ctx -> the context. name -> the name to look for. m -> receives the first matrix with that name.
+		RETURNS: MATRIX_OK when one was taken, MATRIX_ERR_NOT_FOUND when none was found, or MATRIX_ERR_ARGS on invalid parameters.
+	*/
+
+Matrix_Status_t context_take_matrix (Matrix_Context_t* ctx, const char* name, Matrix_t** m) {
+
+	if(!ctx || !name || !m)
+		return MATRIX_ERR_ARGS;
+
+	pthread_mutex_lock(&ctx->lock);
+	const int pos = find_slot(ctx, name);
+	if (pos >= 0) {
+		*m = ctx->mats[pos];
+		ctx->mats[pos] = NULL;
+	}
+	pthread_mutex_unlock(&ctx->lock);
+	return pos >= 0 ? MATRIX_OK : MATRIX_ERR_NOT_FOUND;
+}
+
+	/*
+		PURPOSE: This function looks up a matrix by name and gives the caller a copy of it, made while the context is locked, so it is safe
+			however many threads add to the context meanwhile. The copy belongs to the caller, who must destroy it.
+		INPUTS: ctx -> the context. name -> the name to look for. copy -> receives a copy of the first matrix with that name.
+		RETURNS: MATRIX_OK when one was copied, MATRIX_ERR_NOT_FOUND when none was found, MATRIX_ERR_ARGS on invalid parameters or
+			MATRIX_ERR_NO_MEMORY when memory ran out.
+	*/
+
+Matrix_Status_t context_copy_matrix (Matrix_Context_t* ctx, const char* name, Matrix_t** copy) {
+
+	if(!ctx || !name || !copy)
+		return MATRIX_ERR_ARGS;
+
+	pthread_mutex_lock(&ctx->lock);
+	Matrix_Status_t status = MATRIX_ERR_NOT_FOUND;
+	const int pos = find_slot(ctx, name);
+	if (pos >= 0) {
+		const Matrix_t* src = ctx->mats[pos];
+		Matrix_t* dup = NULL;
+		status = create_matrix_status(&dup, src->name, src->rows, src->cols);
+		if (status == MATRIX_OK) {
+			memcpy(dup->data, src->data, (size_t) src->rows * src->cols * sizeof(unsigned int));
+			*copy = dup;
+		}
+	}
+	pthread_mutex_unlock(&ctx->lock);
+	return status;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function finds the first slot holding a matrix with the given name. The caller holds the context lock.
+		INPUTS: ctx -> the context. name -> the name to look for.
+		RETURNS: the slot, or -1 when no matrix has that name.
+	*/
+
+static int find_slot (Matrix_Context_t* ctx, const char* name) {
+
+	for (unsigned int i = 0; i < ctx->num_mats; ++i) {
+		if (ctx->mats[i] && strncmp(ctx->mats[i]->name, name, MATRIX_NAME_LEN) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,24 @@
+#ifndef _CONTEXT_H_
+#define _CONTEXT_H_
+
+#include <pthread.h>
+
+#include "matrix.h"
+
+/* a table of named matrices, the slots are reused round robin once every one is taken */
+typedef struct {
+	Matrix_t** mats;
+	unsigned int num_mats;
+	unsigned long long next_slot; /* how many matrices were ever added, the next one goes to next_slot % num_mats */
+	pthread_mutex_t lock; /* held while the table is searched or changed */
+}Matrix_Context_t;
+
+Matrix_Status_t create_matrix_context (Matrix_Context_t** ctx, unsigned int num_mats);
+void destroy_matrix_context (Matrix_Context_t** ctx);
+Matrix_Status_t context_add_matrix (Matrix_Context_t* ctx, Matrix_t* new_matrix, unsigned int* slot);
+Matrix_Status_t context_add_matrix_at (Matrix_Context_t* ctx, Matrix_t* new_matrix, unsigned long long position, unsigned int* slot);
+Matrix_Status_t context_find_matrix (Matrix_Context_t* ctx, const char* name, Matrix_t** m);
+Matrix_Status_t context_copy_matrix (Matrix_Context_t* ctx, const char* name, Matrix_t** copy);
+Matrix_Status_t context_take_matrix (Matrix_Context_t* ctx, const char* name, Matrix_t** m);
+
+#endif
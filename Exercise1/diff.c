@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include "diff.h"
+#include "parallel.h"
+
+/* per worker results, padded so workers never share a cache line */
+typedef struct {
+	unsigned long long mismatches;
+	unsigned int max_abs_diff;
+	unsigned int num_reports;
+	bool stopped;
+	char pad[64];
+}Diff_Partial_t;
+
+typedef struct {
+	const Matrix_t* a;
+	const Matrix_t* b;
+	Matrix_Diff_t* diff;
+	Diff_Partial_t* partials;
+	Matrix_Mismatch_t* reports; /* max_reports slots per worker */
+	unsigned int lowest_full_worker; /* lowest worker whose reports are full, read and written atomically */
+}Diff_Job_t;
+
+/*protected functions*/
+static void diff_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+
+	/*
+		PURPOSE: This function compares two matrices of the same shape cell by cell. It counts the cells whose absolute difference exceeds
+			diff->tolerance, per block of DIFF_BLOCK_ROWS rows and in total, finds the largest absolute difference and records the first
+			diff->max_reports mismatching cells in row-major order. Identical rows are skipped with memcmp, the remaining rows are scanned with
+			a branch free loop the compiler vectorizes, and rows are split across workers. With diff->stop_early set a worker stops as soon
+			as its own reports are full or a worker covering earlier rows has filled its reports, because nothing it finds can be reported.
+		INPUTS: a, b -> the matrices to compare. diff -> tolerance, max_reports and stop_early are read, the remaining fields receive the result.
+		RETURNS: true if the comparison ran, the result must then be released with destroy_diff. false on invalid parameters, mismatched
+			shapes or when memory ran out.
+	*/
+
+bool diff_matrices (Matrix_t* a, Matrix_t* b, Matrix_Diff_t* diff) {
+
+	if(!a || !b || !a->data || !b->data || !diff)
+		return false;
+
+	if (a->rows != b->rows || a->cols != b->cols)
+		return false;
+
+	unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+	const unsigned int workers = parallel_partition(a->rows, a->cols, bounds);
+	diff->num_blocks = (a->rows + DIFF_BLOCK_ROWS - 1) / DIFF_BLOCK_ROWS;
+	diff->block_mismatches = calloc(diff->num_blocks, sizeof(unsigned long long));
+	diff->reports = calloc(diff->max_reports ? diff->max_reports : 1, sizeof(Matrix_Mismatch_t));
+	Diff_Partial_t* partials = calloc(workers, sizeof(Diff_Partial_t));
+	Matrix_Mismatch_t* reports = calloc((size_t) workers * (diff->max_reports ? diff->max_reports : 1), sizeof(Matrix_Mismatch_t));
+	if (!diff->block_mismatches || !diff->reports || !partials || !reports) {
+		free(partials);
+		free(reports);
+		destroy_diff(diff);
+		return false;
+	}
+
+	Diff_Job_t job = {a, b, diff, partials, reports, UINT_MAX};
+	parallel_for_bounds(bounds, workers, diff_row_range, &job);
+
+	diff->complete = true;
+	diff->mismatches = 0;
+	diff->max_abs_diff = 0;
+	diff->num_reports = 0;
+	for (unsigned int w = 0; w < workers; ++w) {
+		diff->mismatches += partials[w].mismatches;
+		if (partials[w].max_abs_diff > diff->max_abs_diff) {
+			diff->max_abs_diff = partials[w].max_abs_diff;
+		}
+		if (partials[w].stopped) {
+			diff->complete = false;
+		}
+		/* workers cover increasing rows, so concatenating their reports keeps row-major order */
+		for (unsigned int r = 0; r < partials[w].num_reports && diff->num_reports < diff->max_reports; ++r) {
+			diff->reports[diff->num_reports++] = reports[(size_t) w * diff->max_reports + r];
+		}
+	}
+
+	free(partials);
+	free(reports);
+	return true;
+}
+
+	/*
+		PURPOSE: This function releases the arrays allocated by diff_matrices.
+		INPUTS: diff -> the result filled in by diff_matrices.
+		RETURNS: Nothing.
+	*/
+
+void destroy_diff (Matrix_Diff_t* diff) {
+
+	if(!diff)
+		return;
+
+	free(diff->reports);
+	free(diff->block_mismatches);
+	diff->reports = NULL;
+	diff->block_mismatches = NULL;
+	diff->num_reports = 0;
+	diff->num_blocks = 0;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function is the per worker body of diff_matrices.
+		INPUTS: first_row, end_row -> the rows to compare. worker -> the index of the partial to fill. arg -> the Diff_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void diff_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Diff_Job_t* job = arg;
+	const Matrix_t* a = job->a;
+	const Matrix_t* b = job->b;
+	Matrix_Diff_t* diff = job->diff;
+	Diff_Partial_t* p = &job->partials[worker];
+	Matrix_Mismatch_t* reports = &job->reports[(size_t) worker * diff->max_reports];
+	const unsigned int tolerance = diff->tolerance;
+	const unsigned int cols = a->cols;
+
+	for (unsigned int i = first_row; i < end_row; ++i) {
+		if (diff->stop_early && __atomic_load_n(&job->lowest_full_worker, __ATOMIC_RELAXED) < worker) {
+			p->stopped = true;
+			return;
+		}
+
+		const unsigned int* x = &a->data[(size_t) i * cols];
+		const unsigned int* y = &b->data[(size_t) i * cols];
+		if (memcmp(x, y, cols * sizeof(unsigned int)) == 0) {
+			continue;
+		}
+
+		unsigned int row_mismatches = 0;
+		unsigned int row_max = 0;
+		for (unsigned int j = 0; j < cols; ++j) {
+			const unsigned int d = x[j] > y[j] ? x[j] - y[j] : y[j] - x[j];
+			row_mismatches += d > tolerance;
+			row_max = d > row_max ? d : row_max;
+		}
+		if (row_mismatches == 0) {
+			continue;
+		}
+
+		p->mismatches += row_mismatches;
+		p->max_abs_diff = row_max > p->max_abs_diff ? row_max : p->max_abs_diff;
+		/* rows of one block can belong to two workers */
+		__atomic_fetch_add(&diff->block_mismatches[i / DIFF_BLOCK_ROWS], row_mismatches, __ATOMIC_RELAXED);
+
+		for (unsigned int j = 0; j < cols && p->num_reports < diff->max_reports; ++j) {
+			const unsigned int d = x[j] > y[j] ? x[j] - y[j] : y[j] - x[j];
+			if (d > tolerance) {
+				Matrix_Mismatch_t mismatch = {i, j, x[j], y[j]};
+				reports[p->num_reports++] = mismatch;
+			}
+		}
+
+		if (diff->stop_early && p->num_reports == diff->max_reports) {
+			/* publish that rows from here on can no longer be reported */
+			unsigned int lowest = __atomic_load_n(&job->lowest_full_worker, __ATOMIC_RELAXED);
+			while (worker < lowest
+				&& !__atomic_compare_exchange_n(&job->lowest_full_worker, &lowest, worker, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+			}
+			if (i + 1 < end_row) {
+				p->stopped = true;
+			}
+			return;
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef _DIFF_H_
+#define _DIFF_H_
+
+#include "matrix.h"
+
+/* mismatch counts are kept per block of this many rows */
+#define DIFF_BLOCK_ROWS 1024
+
+typedef struct {
+	unsigned int row;
+	unsigned int col;
+	unsigned int a;
+	unsigned int b;
+}Matrix_Mismatch_t;
+
+typedef struct {
+	/* request: filled in by the caller */
+	unsigned int tolerance; /* cells whose absolute difference is at most this compare equal */
+	unsigned int max_reports; /* how many leading mismatches to report */
+	bool stop_early; /* stop scanning once max_reports leading mismatches are known */
+
+	/* result: filled in by diff_matrices, released with destroy_diff */
+	bool complete; /* false when stop_early cut the scan short, the counts then cover the scanned part only */
+	unsigned long long mismatches;
+	unsigned int max_abs_diff;
+	unsigned int num_reports;
+	Matrix_Mismatch_t* reports; /* the first num_reports mismatches in row-major order */
+	unsigned int num_blocks;
+	unsigned long long* block_mismatches; /* mismatches in rows [i * DIFF_BLOCK_ROWS, (i + 1) * DIFF_BLOCK_ROWS) */
+}Matrix_Diff_t;
+
+bool diff_matrices (Matrix_t* a, Matrix_t* b, Matrix_Diff_t* diff);
+void destroy_diff (Matrix_Diff_t* diff);
+
+#endif
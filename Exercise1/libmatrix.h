@@ -0,0 +1,39 @@
+#ifndef _LIBMATRIX_H_
+#define _LIBMATRIX_H_
+
+/*
+ * The header for programs linking libmatrix.a or libmatrix.so instead of running matlab.
+ *
+ * All state lives in the objects the caller creates: matrices, bit matrices, batches and contexts. The library has no globals apart from
+ * the NUMA topology, which is read once and never changes, and the rand sequence random_matrix draws from; random_matrix_seeded keeps
+ * its state with the caller. Nothing in the library prints except the display and print functions. Functions that can fail for more
+ * than one reason return a Matrix_Status_t, the rest return false only on invalid parameters, mismatched dimensions or when memory ran
+ * out.
+ *
+ * Any number of threads may call the library at once as long as no matrix is changed by one thread while another uses it. A context may
+ * be shared; take a matrix out of it with context_take_matrix to work on it without holding anything.
+ */
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "matrix.h"
+#include "context.h"
+#include "session.h"
+#include "parallel.h"
+#include "stats.h"
+#include "diff.h"
+#include "bitmatrix.h"
+#include "stencil.h"
+#include "sort.h"
+#include "prefix.h"
+#include "batch.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef _LIBMATRIX_HPP_
+#define _LIBMATRIX_HPP_
+
+/*
+ * C++ wrappers over libmatrix.h. A Matrix or Context owns what it wraps and destroys it when it goes out of scope; both can be moved but
+ * not copied, so ownership is never shared by accident. Failures throw libmatrix::Error carrying the Matrix_Status_t.
+ */
+
+#include <stdexcept>
+#include <string>
+
+#include "libmatrix.h"
+
+namespace libmatrix {
+
+class Error : public std::runtime_error {
+public:
+	explicit Error (Matrix_Status_t status) : std::runtime_error(matrix_status_string(status)), status_(status) {}
+	Matrix_Status_t status () const noexcept { return status_; }
+
+private:
+	Matrix_Status_t status_;
+};
+
+inline void check (Matrix_Status_t status) {
+
+	if (status != MATRIX_OK) {
+		throw Error(status);
+	}
+}
+
+/* for the functions that only return a bool, failure names the likeliest reason */
+inline void check (bool ok, Matrix_Status_t failure = MATRIX_ERR_ARGS) {
+
+	if (!ok) {
+		throw Error(failure);
+	}
+}
+
+class Matrix {
+public:
+	Matrix () noexcept : m_(nullptr) {}
+
+	Matrix (const std::string& name, unsigned int rows, unsigned int cols) : m_(nullptr) {
+		check(create_matrix_status(&m_, name.c_str(), rows, cols));
+	}
+
+	/* adopts a matrix made by the C functions */
+	explicit Matrix (Matrix_t* m) noexcept : m_(m) {}
+
+	Matrix (Matrix&& other) noexcept : m_(other.release()) {}
+
+	Matrix& operator= (Matrix&& other) noexcept {
+		if (this != &other) {
+			destroy_matrix(&m_);
+			m_ = other.release();
+		}
+		return *this;
+	}
+
+	Matrix (const Matrix&) = delete;
+	Matrix& operator= (const Matrix&) = delete;
+
+	~Matrix () { destroy_matrix(&m_); }
+
+	/* a file left behind by an interrupted incremental write throws MATRIX_TORN_FILE unless allow_torn is set */
+	static Matrix read (const std::string& filename, bool allow_torn = false) {
+		Matrix_t* m = nullptr;
+		Matrix_Status_t status = read_matrix_status(filename.c_str(), &m);
+		if (status == MATRIX_TORN_FILE && allow_torn) {
+			status = MATRIX_OK;
+		}
+		Matrix read_mat(m);
+		check(status);
+		return read_mat;
+	}
+
+	void write (const std::string& filename) { check(write_matrix_status(filename.c_str(), m_)); }
+
+	Matrix_t* get () const noexcept { return m_; }
+
+	Matrix_t* release () noexcept {
+		Matrix_t* m = m_;
+		m_ = nullptr;
+		return m;
+	}
+
+	explicit operator bool () const noexcept { return m_ != nullptr; }
+
+	std::string name () const { return m_ ? std::string(m_->name) : std::string(); }
+	unsigned int rows () const noexcept { return m_ ? m_->rows : 0; }
+	unsigned int cols () const noexcept { return m_ ? m_->cols : 0; }
+
+	unsigned int at (unsigned int row, unsigned int col) const {
+		check(m_ && row < m_->rows && col < m_->cols);
+		return m_->data[(size_t) row * m_->cols + col];
+	}
+
+	void set (unsigned int row, unsigned int col, unsigned int value) {
+		check(m_ && row < m_->rows && col < m_->cols);
+		m_->data[(size_t) row * m_->cols + col] = value;
+		mark_matrix_dirty(m_, row, row + 1);
+	}
+
+	void randomize (unsigned int start_range, unsigned int end_range, unsigned int& seed) {
+		check(random_matrix_seeded(m_, start_range, end_range, &seed));
+	}
+
+	Matrix duplicate (const std::string& name) const {
+		check(m_ != nullptr);
+		Matrix dup(name, m_->rows, m_->cols);
+		check(duplicate_matrix(m_, dup.m_));
+		return dup;
+	}
+
+	void add (const Matrix& b, Matrix& result) const { check(add_matrices(m_, b.m_, result.m_), MATRIX_ERR_SHAPE); }
+	void apply (Matrix_Op_t op, unsigned int value) { check(scalar_op_matrix(m_, op, value)); }
+	void apply (Matrix_Op_t op, const Matrix& v) { check(broadcast_op_matrix(m_, v.m_, op), MATRIX_ERR_SHAPE); }
+	void shift (char direction, unsigned int shift) { check(bitwise_shift_matrix(m_, direction, shift)); }
+	void sort () { check(sort_matrix(m_), MATRIX_ERR_NO_MEMORY); }
+	void sort_rows (unsigned int col) { check(sort_matrix_rows(m_, col)); }
+
+	unsigned int percentile (double p) const {
+		unsigned int value = 0;
+		check(percentile_matrix(m_, p, &value));
+		return value;
+	}
+
+	/* not const, the first call builds the prefix sum index */
+	unsigned long long range_sum (unsigned int r0, unsigned int c0, unsigned int r1, unsigned int c1) {
+		unsigned long long sum = 0;
+		check(range_sum_matrix(m_, r0, c0, r1, c1, &sum));
+		return sum;
+	}
+
+	bool operator== (const Matrix& other) const { return equal_matrices(m_, other.m_); }
+	bool operator!= (const Matrix& other) const { return !(*this == other); }
+
+	void print (FILE* out) const {
+		if (m_) {
+			print_matrix(out, m_);
+		}
+	}
+
+private:
+	Matrix_t* m_;
+};
+
+class Context {
+public:
+	explicit Context (unsigned int num_mats = 10) : ctx_(nullptr) { check(create_matrix_context(&ctx_, num_mats)); }
+
+	Context (Context&& other) noexcept : ctx_(other.ctx_) { other.ctx_ = nullptr; }
+
+	Context& operator= (Context&& other) noexcept {
+		if (this != &other) {
+			destroy_matrix_context(&ctx_);
+			ctx_ = other.ctx_;
+			other.ctx_ = nullptr;
+		}
+		return *this;
+	}
+
+	Context (const Context&) = delete;
+	Context& operator= (const Context&) = delete;
+
+	~Context () { destroy_matrix_context(&ctx_); }
+
+	Matrix_Context_t* get () const noexcept { return ctx_; }
+
+	/* the context owns the matrix from now on, the oldest one is destroyed once every slot is taken */
+	unsigned int add (Matrix&& m) {
+		unsigned int slot = 0;
+		check(context_add_matrix(ctx_, m.get(), &slot));
+		m.release();
+		return slot;
+	}
+
+	Matrix take (const std::string& name) {
+		Matrix_t* m = nullptr;
+		check(context_take_matrix(ctx_, name.c_str(), &m));
+		return Matrix(m);
+	}
+
+	/* a copy made under the context lock, so it stays valid whatever other threads add meanwhile */
+	Matrix find (const std::string& name) const {
+		Matrix_t* m = nullptr;
+		check(context_copy_matrix(ctx_, name.c_str(), &m));
+		return Matrix(m);
+	}
+
+	void save (const std::string& filename) { check(save_session(filename.c_str(), ctx_), MATRIX_ERR_IO); }
+
+	unsigned int load (const std::string& filename) {
+		unsigned int restored = 0;
+		check(load_session(filename.c_str(), ctx_, &restored));
+		return restored;
+	}
+
+private:
+	Matrix_Context_t* ctx_;
+};
+
+}
+
+#endif
@@ -5,17 +5,45 @@
 #include <math.h>
 #include <stdbool.h>
 #include <time.h>
+#include <unistd.h>
 
 #include<readline/readline.h>
 
 #include "command.h"
 #include "matrix.h"
+#include "session.h"
+#include "stats.h"
+#include "diff.h"
+#include "scheduler.h"
+#include "context.h"
+#include "parallel.h"
+#include "topology.h"
+#include "bitmatrix.h"
+#include "stencil.h"
+#include "sort.h"
+#include "prefix.h"
+#include "batch.h"
 
-void run_commands (Commands_t* cmd, Matrix_t** mats, unsigned int num_mats);
+#define NUM_BIT_MATS 10
+#define NUM_BATCHES 10
+
+/* packed matrices live in their own table, the dense matrix array keeps its layout */
+static Bit_Matrix_t* bit_mats[NUM_BIT_MATS];
+static Matrix_Batch_t* batches[NUM_BATCHES];
+
+void run_commands (Commands_t* cmd, Matrix_Context_t* ctx, FILE* out);
 unsigned int find_matrix_given_name (Matrix_t** mats, unsigned int num_mats, 
 			const char* target);
 
-void destroy_remaining_heap_allocations(Matrix_t **mats, unsigned int num_mats);
+int find_bit_matrix_given_name (const char* target);
+bool publish_bit_matrix (Bit_Matrix_t* m);
+bool get_bit_result (const char* name, unsigned int rows, unsigned int cols, Bit_Matrix_t** result, bool* is_new);
+Matrix_t* get_filter_result (Matrix_t** mats, unsigned int num_mats, const char* name, Matrix_t* src, Matrix_t* kernel,
+			bool* is_new, Matrix_t** copy_to);
+bool store_filter_result (Matrix_Context_t* ctx, Matrix_t* c, bool is_new, Matrix_t* copy_to);
+int find_batch_given_name (const char* target);
+bool publish_batch (Matrix_Batch_t* b);
+bool get_batch_result (const char* name, unsigned int count, unsigned int rows, unsigned int cols, Matrix_Batch_t** result, bool* is_new);
 
 	/*
 		PURPOSE: This function is the main driver of the entire program, it feeds every other aspect of the program. Meaning it reads in the users' input
@@ -31,8 +59,12 @@ int main (int argc, char **argv) {
 	char *line = NULL;
 	Commands_t* cmd;
 
-	Matrix_t *mats[10];
-	memset(&mats,0, sizeof(Matrix_t*) * 10); // IMPORTANT C FUNCTION TO LEARN
+	Matrix_Context_t* ctx = NULL;
+	if (create_matrix_context(&ctx, 10) != MATRIX_OK) {
+		printf("Failed to create the matrix array.\n");
+		return -1;
+	}
+	Matrix_t** mats = ctx->mats;
 
 	Matrix_t *temp = NULL;
 	bool create_result = create_matrix (&temp,"temp_mat", 5, 5);
@@ -44,8 +76,8 @@ int main (int argc, char **argv) {
 	if(temp == NULL)
 		return -1;
 
-	int result = add_matrix_to_array(mats,temp, 10);
-	if(result < 0 || result > 9){
+	unsigned int result = 0;
+	if(context_add_matrix(ctx, temp, &result) != MATRIX_OK || result > 9){
 		printf("Failed to add matrix to array.\n");
 		return -1; 
 	}
@@ -67,24 +99,49 @@ int main (int argc, char **argv) {
 		return -1;
 	}
 
+	/* a script piped in runs through the scheduler, an interactive session runs each command as it is typed */
+	Scheduler_t* sched = NULL;
+	if (!isatty(STDIN_FILENO)) {
+		const unsigned int workers = parallel_worker_count() < 2 ? 2 : parallel_worker_count();
+		if (!create_scheduler(&sched, workers, run_commands, ctx)) {
+			sched = NULL;
+		}
+		/* the echoed script goes to stderr, so stdout holds only the output of the commands and in script order */
+		rl_outstream = stderr;
+	}
+
 	line = readline("> ");
-	while (strncmp(line,"exit", strlen("exit")  + 1) != 0) {
+	while (line && strncmp(line,"exit", strlen("exit")  + 1) != 0) {
 		
 		if (!parse_user_input(line,&cmd)) {
 			printf("Failed at parsing command\n\n");
 		}
-		
-		if (cmd->num_cmds > 1) {	
-			run_commands(cmd,mats,10);
+		else if (cmd->num_cmds == 1 && strncmp(cmd->cmds[0],"sync",strlen("sync") + 1) == 0) {
+			sync_scheduler(sched);
+			destroy_commands(&cmd);
+		}
+		else if (cmd->num_cmds > 1 && sched && submit_command(sched,cmd)) {
+			/* the scheduler owns the command now */
+			cmd = NULL;
 		}
-		if (line) {
-			free(line);
+		else {
+			if (cmd->num_cmds > 1) {	
+				run_commands(cmd,ctx,stdout);
+			}
+			destroy_commands(&cmd);
 		}
-		destroy_commands(&cmd);
+		free(line);
 		line = readline("> ");
 	}
 	free(line);
-	destroy_remaining_heap_allocations(mats,10);
+	destroy_scheduler(&sched);
+	destroy_matrix_context(&ctx);
+	for (unsigned int i = 0; i < NUM_BIT_MATS; ++i) {
+		destroy_bit_matrix(&bit_mats[i]);
+	}
+	for (unsigned int i = 0; i < NUM_BATCHES; ++i) {
+		destroy_batch(&batches[i]);
+	}
 	return 0;	
 }
 
@@ -92,26 +149,24 @@ int main (int argc, char **argv) {
 		PURPOSE: This function compares the first element of the cmd array cmd->cmds to a given set of strings, and if any of the match, 
 			a given matrix function / operation is then called.  
 		INPUT: This function takes in the cmd structure, which contains a field for the number of cmds currently being executed, and the command array, 
-			which holds the commands themselves. It also takes in the array of matrixes, and the total number of matrixes that are present in the array. 
+			which holds the commands themselves. It also takes in the context holding the array of matrixes. 
+			Everything the command prints goes to out, so the scheduler can capture it and print it in submission order. 
 		RETURNS: This function is void, meaning that it doesn't return anything, it just parses out the commands, and evaluates if any of them 
 			can be ran, and if so, it runs them and leaves the function, otherwise it does nothing. 
 	*/
-void run_commands (Commands_t* cmd, Matrix_t** mats, unsigned int num_mats) {
+void run_commands (Commands_t* cmd, Matrix_Context_t* ctx, FILE* out) {
 
 	if(cmd == NULL){
-		printf("Command container was null.\n");
+		fprintf(out, "Command container was null.\n");
 		return; 
 	}
 
-	if(mats == NULL){
-		printf("No initialized matrixes in the array.\n");
-		return; 
-	}
-
-	if(num_mats < 0){
-		printf("Invalid number of possible matrixes.\n");
+	if(ctx == NULL || ctx->mats == NULL){
+		fprintf(out, "No initialized matrixes in the array.\n");
 		return; 
 	}
+	Matrix_t** mats = ctx->mats;
+	const unsigned int num_mats = ctx->num_mats;
 
 	/*Parsing and calling of commands*/
 	if (strncmp(cmd->cmds[0],"display",strlen("display") + 1) == 0
@@ -120,10 +175,10 @@ void run_commands (Commands_t* cmd, Matrix_t** mats, unsigned int num_mats) {
 
 			int idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
 			if (idx >= 0) {
-				display_matrix (mats[idx]);
+				print_matrix (out, mats[idx]);
 			}
 			else {
-				printf("Matrix (%s) doesn't exist\n", cmd->cmds[1]);
+				fprintf(out, "Matrix (%s) doesn't exist\n", cmd->cmds[1]);
 				return;
 			}
 	}
@@ -132,25 +187,85 @@ void run_commands (Commands_t* cmd, Matrix_t** mats, unsigned int num_mats) {
 			int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
 			int mat2_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[2]);
 			if (mat1_idx >= 0 && mat2_idx >= 0) {
+				/* an existing result of the same shape is accumulated into in place, one of another shape is left alone */
+				int mat3_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[3]);
+				if (mat3_idx >= 0 && (mats[mat3_idx]->rows != mats[mat1_idx]->rows
+					|| mats[mat3_idx]->cols != mats[mat1_idx]->cols)) {
+					fprintf(out, "Matrix (%s) already exists with different dimensions\n", mats[mat3_idx]->name);
+					return;
+				}
+				if (mat3_idx >= 0) {
+					if (! add_matrices(mats[mat1_idx], mats[mat2_idx], mats[mat3_idx]) ) {
+						fprintf(out, "Failure to add %s with %s into %s\n", mats[mat1_idx]->name, mats[mat2_idx]->name, mats[mat3_idx]->name);
+					}
+					return;
+				}
+
 				Matrix_t* c = NULL;
 				if( !create_matrix (&c,cmd->cmds[3], mats[mat1_idx]->rows, 
 						mats[mat1_idx]->cols)) {
-					printf("Failure to create the result Matrix (%s)\n", cmd->cmds[3]);
+					fprintf(out, "Failure to create the result Matrix (%s)\n", cmd->cmds[3]);
 					return;
 				}
-			
-				int add_result = add_matrix_to_array(mats,c, num_mats);
-					if(add_result < 0 || add_result > 9){
-						printf("Failed to add matrix to array.\n");
-					return; 
-					}
 
+				/* add before inserting, the insert may evict one of the operands */
 				if (! add_matrices(mats[mat1_idx], mats[mat2_idx],c) ) {
-					printf("Failure to add %s with %s into %s\n", mats[mat1_idx]->name, mats[mat2_idx]->name,c->name);
+					fprintf(out, "Failure to add %s with %s into %s\n", mats[mat1_idx]->name, mats[mat2_idx]->name,c->name);
+					destroy_matrix(&c);
 					return;	
 				}
+
+				int add_result = publish_matrix(ctx, c);
+				if(add_result < 0 || add_result > 9){
+					fprintf(out, "Failed to add matrix to array.\n");
+					destroy_matrix(&c);
+					return; 
+				}
 			}
 	}
+	else if (strncmp(cmd->cmds[0],"+=",strlen("+=") + 1) == 0
+		&& cmd->num_cmds == 3) {
+		int dst_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		int src_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[2]);
+		if (dst_idx < 0 || src_idx < 0) {
+			fprintf(out, "Matrix (%s) or (%s) doesn't exist\n", cmd->cmds[1], cmd->cmds[2]);
+			return;
+		}
+		if (! add_matrices(mats[dst_idx], mats[src_idx], mats[dst_idx]) ) {
+			fprintf(out, "Failure to add %s into %s\n", mats[src_idx]->name, mats[dst_idx]->name);
+			return;
+		}
+	}
+	else if (strncmp(cmd->cmds[0],"scalar",strlen("scalar") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		Matrix_Op_t op;
+		if (mat1_idx < 0 || !matrix_op_from_name(cmd->cmds[2], &op)) {
+			fprintf(out, "Scalar operation failed\n");
+			return;
+		}
+		const unsigned int value = strtoul(cmd->cmds[3], NULL, 0);
+		if (! scalar_op_matrix(mats[mat1_idx], op, value)) {
+			fprintf(out, "Scalar operation failed\n");
+			return;
+		}
+		fprintf(out, "Matrix (%s) updated with %s %u\n", mats[mat1_idx]->name, cmd->cmds[2], value);
+	}
+	else if (strncmp(cmd->cmds[0],"broadcast",strlen("broadcast") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		int vec_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[2]);
+		Matrix_Op_t op;
+		if (mat1_idx < 0 || vec_idx < 0 || !matrix_op_from_name(cmd->cmds[3], &op)) {
+			fprintf(out, "Broadcast operation failed\n");
+			return;
+		}
+		if (! broadcast_op_matrix(mats[mat1_idx], mats[vec_idx], op)) {
+			fprintf(out, "Vector (%s) is neither 1x%u nor %ux1\n", mats[vec_idx]->name, mats[mat1_idx]->cols, mats[mat1_idx]->rows);
+			return;
+		}
+		fprintf(out, "Matrix (%s) updated with %s %s\n", mats[mat1_idx]->name, cmd->cmds[3], mats[vec_idx]->name);
+	}
 	else if (strncmp(cmd->cmds[0],"duplicate",strlen("duplicate") + 1) == 0
 		&& cmd->num_cmds == 3 && strlen(cmd->cmds[1]) + 1 <= MATRIX_NAME_LEN) {
 		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
@@ -163,40 +278,79 @@ void run_commands (Commands_t* cmd, Matrix_t** mats, unsigned int num_mats) {
 				bool duplicate_result = duplicate_matrix (mats[mat1_idx], dup_mat);
 				
 				if(duplicate_result == false){
-					printf("Failed to duplicate the matrix.\n");
+					fprintf(out, "Failed to duplicate the matrix.\n");
 					return; 
 				}
 
-				int duplicate_add_result = add_matrix_to_array(mats,dup_mat,num_mats);
+				int duplicate_add_result = publish_matrix(ctx, dup_mat);
 				
 				if(duplicate_add_result < 0 || duplicate_add_result > 9){
-					printf("Failed to add the matrix to the array.\n");
+					fprintf(out, "Failed to add the matrix to the array.\n");
 					return; 
 				}else
-					printf ("Duplication of %s into %s finished\n", mats[mat1_idx]->name, cmd->cmds[2]);
+					fprintf(out, "Duplication of %s into %s finished\n", cmd->cmds[1], cmd->cmds[2]);
 		}
 		else {
-			printf("Duplication Failed\n");
+			fprintf(out, "Duplication Failed\n");
 			return;
 		}
 	}
 	else if (strncmp(cmd->cmds[0],"equal",strlen("equal") + 1) == 0
-		&& cmd->num_cmds == 2) {
+		&& cmd->num_cmds == 3) {
 			int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
 			int mat2_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[2]);
 			if (mat1_idx >= 0 && mat2_idx >= 0) {
 				if ( equal_matrices(mats[mat1_idx],mats[mat2_idx]) ) {
-					printf("SAME DATA IN BOTH\n");
+					fprintf(out, "SAME DATA IN BOTH\n");
 				}
 				else {
-					printf("DIFFERENT DATA IN BOTH\n");
+					fprintf(out, "DIFFERENT DATA IN BOTH\n");
 				}
 			}
 			else {
-				printf("Equal Failed\n");
+				fprintf(out, "Equal Failed\n");
 				return;
 			}
 	}
+	else if ((strncmp(cmd->cmds[0],"diff",strlen("diff") + 1) == 0
+		|| strncmp(cmd->cmds[0],"diff-first",strlen("diff-first") + 1) == 0)
+		&& cmd->num_cmds >= 3 && cmd->num_cmds <= 5) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		int mat2_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[2]);
+		if (mat1_idx < 0 || mat2_idx < 0) {
+			fprintf(out, "Matrix (%s) doesn't exist\n", mat1_idx < 0 ? cmd->cmds[1] : cmd->cmds[2]);
+			return;
+		}
+		if (mats[mat1_idx]->rows != mats[mat2_idx]->rows || mats[mat1_idx]->cols != mats[mat2_idx]->cols) {
+			fprintf(out, "Diff Failed, the matrices must have the same dimensions\n");
+			return;
+		}
+		Matrix_Diff_t diff = {0};
+		diff.max_reports = cmd->num_cmds >= 4 ? strtoul(cmd->cmds[3], NULL, 0) : 10;
+		diff.tolerance = cmd->num_cmds == 5 ? strtoul(cmd->cmds[4], NULL, 0) : 0;
+		diff.stop_early = strncmp(cmd->cmds[0],"diff-first",strlen("diff-first") + 1) == 0;
+		if (! diff_matrices(mats[mat1_idx], mats[mat2_idx], &diff)) {
+			fprintf(out, "Diff Failed, out of memory\n");
+			return;
+		}
+		if (diff.mismatches == 0) {
+			fprintf(out, "SAME DATA IN BOTH\n");
+			destroy_diff(&diff);
+			return;
+		}
+		fprintf(out, "%llu cells differ%s, max absolute difference %u\n", diff.mismatches,
+			diff.complete ? "" : " in the scanned rows", diff.max_abs_diff);
+		for (unsigned int i = 0; i < diff.num_reports; ++i) {
+			fprintf(out, "(%u,%u) %u != %u\n", diff.reports[i].row, diff.reports[i].col, diff.reports[i].a, diff.reports[i].b);
+		}
+		for (unsigned int i = 0; i < diff.num_blocks; ++i) {
+			if (diff.block_mismatches[i]) {
+				const unsigned int end_row = (i + 1) * DIFF_BLOCK_ROWS < mats[mat1_idx]->rows ? (i + 1) * DIFF_BLOCK_ROWS : mats[mat1_idx]->rows;
+				fprintf(out, "rows [%u, %u): %llu\n", i * DIFF_BLOCK_ROWS, end_row, diff.block_mismatches[i]);
+			}
+		}
+		destroy_diff(&diff);
+	}
 	else if (strncmp(cmd->cmds[0],"shift",strlen("shift") + 1) == 0
 		&& cmd->num_cmds == 4) {
 		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
@@ -204,14 +358,14 @@ void run_commands (Commands_t* cmd, Matrix_t** mats, unsigned int num_mats) {
 		if (mat1_idx >= 0 ) {
 			bool shift_result = bitwise_shift_matrix(mats[mat1_idx],cmd->cmds[2][0], shift_value);
 			
-			if(shift_result == true){
-				printf("Failed to shift the matrix.\n");
+			if(shift_result == false){
+				fprintf(out, "Failed to shift the matrix.\n");
 				return; 
 			}else
-				printf("Matrix (%s) has been shifted by %d\n", mats[mat1_idx]->name, shift_value);
+				fprintf(out, "Matrix (%s) has been shifted by %d\n", mats[mat1_idx]->name, shift_value);
 		}
 		else {
-			printf("Matrix shift failed\n");
+			fprintf(out, "Matrix shift failed\n");
 			return;
 		}
 
@@ -219,27 +373,32 @@ void run_commands (Commands_t* cmd, Matrix_t** mats, unsigned int num_mats) {
 	else if (strncmp(cmd->cmds[0],"read",strlen("read") + 1) == 0
 		&& cmd->num_cmds == 2) {
 		Matrix_t* new_matrix = NULL;
-		if(! read_matrix(cmd->cmds[1],&new_matrix)) {
-			printf("Read Failed\n");
+		Matrix_Status_t read_status = read_matrix_status(cmd->cmds[1],&new_matrix);
+		if (read_status == MATRIX_TORN_FILE) {
+			fprintf(out, "WARNING: %s WAS INTERRUPTED DURING AN INCREMENTAL WRITE\n", cmd->cmds[1]);
+		}
+		else if(read_status != MATRIX_OK) {
+			fprintf(out, "Read Failed: %s\n", matrix_status_string(read_status));
 			return;
 		}	
 		
-		int result_add = add_matrix_to_array(mats,new_matrix, num_mats);
+		int result_add = publish_matrix(ctx, new_matrix);
 			
 		if(result_add < 0 || result_add > 9){
-			printf("Failed to add the matrix to the array.\n");
+			fprintf(out, "Failed to add the matrix to the array.\n");
 			return; 
 		}else{
-			printf("Matrix (%s) is read from the filesystem\n", cmd->cmds[1]);	
+			fprintf(out, "Matrix (%s) is read from the filesystem\n", cmd->cmds[1]);	
 		}
 	}else if (strncmp(cmd->cmds[0],"write",strlen("write") + 1) == 0
 		&& cmd->num_cmds == 2) {
 		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
-		if(! write_matrix(mats[mat1_idx]->name,mats[mat1_idx])) {
-			printf("Write Failed\n");
+		Matrix_Status_t write_status = mat1_idx < 0 ? MATRIX_ERR_NOT_FOUND : write_matrix_status(mats[mat1_idx]->name,mats[mat1_idx]);
+		if(write_status != MATRIX_OK) {
+			fprintf(out, "Write Failed: %s\n", matrix_status_string(write_status));
 			return;
 		}else {
-			printf("Matrix (%s) is wrote out to the filesystem\n", mats[mat1_idx]->name);
+			fprintf(out, "Matrix (%s) is wrote out to the filesystem\n", mats[mat1_idx]->name);
 		}
 	}
 	else if (strncmp(cmd->cmds[0], "create", strlen("create") + 1) == 0
@@ -248,28 +407,585 @@ void run_commands (Commands_t* cmd, Matrix_t** mats, unsigned int num_mats) {
 		const unsigned int rows = atoi(cmd->cmds[2]);
 		const unsigned int cols = atoi(cmd->cmds[3]);
 
-		bool create_result = create_matrix(&new_mat,cmd->cmds[1],rows, cols);
-		if(create_result == false){
+		Matrix_Status_t create_status = create_matrix_status(&new_mat,cmd->cmds[1],rows, cols);
+		if(create_status != MATRIX_OK){
+			fprintf(out, "Create Failed: %s\n", matrix_status_string(create_status));
 			return; 
 		}
-		int add_result_final = add_matrix_to_array(mats,new_mat,num_mats);
+		int add_result_final = publish_matrix(ctx, new_mat);
 		if(add_result_final > 9 || add_result_final < 0){
 			return; 
 		}
-		printf("Created Matrix (%s,%u,%u)\n", new_mat->name, new_mat->rows, new_mat->cols);
+		fprintf(out, "Created Matrix (%s,%u,%u)\n", cmd->cmds[1], rows, cols);
 	}
 	else if (strncmp(cmd->cmds[0], "random", strlen("random") + 1) == 0
-		&& cmd->num_cmds == 4) {
+		&& (cmd->num_cmds == 4 || cmd->num_cmds == 5)) {
 		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		if (mat1_idx < 0) {
+			fprintf(out, "Matrix (%s) doesn't exist\n", cmd->cmds[1]);
+			return;
+		}
 		const unsigned int start_range = atoi(cmd->cmds[2]);
 		const unsigned int end_range = atoi(cmd->cmds[3]);
-		bool random_result = random_matrix(mats[mat1_idx],start_range, end_range);
+		/* a seed makes the values repeatable, which the scripted tests rely on */
+		unsigned int seed = cmd->num_cmds == 5 ? strtoul(cmd->cmds[4], NULL, 0) : 0;
+		bool random_result = cmd->num_cmds == 5 ? random_matrix_seeded(mats[mat1_idx], start_range, end_range, &seed)
+			: random_matrix(mats[mat1_idx],start_range, end_range);
 		if(random_result == false)
 			return; 
-		printf("Matrix (%s) is randomized between %u %u\n", mats[mat1_idx]->name, start_range, end_range);
+		fprintf(out, "Matrix (%s) is randomized between %u %u\n", mats[mat1_idx]->name, start_range, end_range);
+	}
+	else if (strncmp(cmd->cmds[0], "sum", strlen("sum") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		Matrix_Stats_t stats = {0};
+		if (mat1_idx < 0 || !stats_matrix(mats[mat1_idx], &stats)) {
+			fprintf(out, "Sum Failed\n");
+			return;
+		}
+		fprintf(out, "Sum of Matrix (%s) = %llu\n", mats[mat1_idx]->name, stats.sum);
+	}
+	else if (strncmp(cmd->cmds[0], "stats", strlen("stats") + 1) == 0
+		&& (cmd->num_cmds == 2 || cmd->num_cmds == 5)) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		if (mat1_idx < 0) {
+			fprintf(out, "Matrix (%s) doesn't exist\n", cmd->cmds[1]);
+			return;
+		}
+		Matrix_Stats_t stats = {0};
+		if (cmd->num_cmds == 5) {
+			stats.num_bins = strtoul(cmd->cmds[2], NULL, 0);
+			stats.hist_low = strtoul(cmd->cmds[3], NULL, 0);
+			stats.hist_high = strtoul(cmd->cmds[4], NULL, 0);
+		}
+		if (!stats_matrix(mats[mat1_idx], &stats)) {
+			fprintf(out, "Stats Failed\n");
+			return;
+		}
+		fprintf(out, "\nStatistics (%s):\n", mats[mat1_idx]->name);
+		fprintf(out, "MIN = %u\nMAX = %u\nSUM = %llu\nMEAN = %f\nVARIANCE = %f\nNONZERO = %llu\n",
+			stats.min, stats.max, stats.sum, stats.mean, stats.variance, stats.nonzero);
+		for (unsigned int b = 0; b < stats.num_bins; ++b) {
+			const unsigned long long range = (unsigned long long) stats.hist_high - stats.hist_low + 1;
+			fprintf(out, "[%llu, %llu) %llu\n", stats.hist_low + range * b / stats.num_bins,
+				stats.hist_low + range * (b + 1) / stats.num_bins, stats.counts[b]);
+		}
+		fprintf(out, "\n");
+		destroy_stats(&stats);
+	}
+	else if (strncmp(cmd->cmds[0], "topk", strlen("topk") + 1) == 0
+		&& cmd->num_cmds == 3) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		unsigned int k = strtoul(cmd->cmds[2], NULL, 0);
+		if (mat1_idx < 0 || k == 0) {
+			fprintf(out, "Topk Failed\n");
+			return;
+		}
+		/* a k past the number of cells asks for all of them, the buffer needs no more */
+		if ((unsigned long long) k > (unsigned long long) mats[mat1_idx]->rows * mats[mat1_idx]->cols) {
+			k = mats[mat1_idx]->rows * mats[mat1_idx]->cols;
+		}
+		Matrix_Cell_t* cells = calloc(k, sizeof(Matrix_Cell_t));
+		if (!cells) {
+			fprintf(out, "Topk Failed\n");
+			return;
+		}
+		unsigned int found = topk_matrix(mats[mat1_idx], k, cells);
+		for (unsigned int i = 0; i < found; ++i) {
+			fprintf(out, "(%u,%u) = %u\n", cells[i].row, cells[i].col, cells[i].value);
+		}
+		free(cells);
+	}
+	else if (strncmp(cmd->cmds[0], "info", strlen("info") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		if (mat1_idx < 0) {
+			fprintf(out, "Matrix (%s) doesn't exist\n", cmd->cmds[1]);
+			return;
+		}
+		Matrix_t* m = mats[mat1_idx];
+		static const char* placements[] = {"heap", "first-touch", "interleave"};
+		fprintf(out, "Matrix (%s,%u,%u) %zu bytes\n", m->name, m->rows, m->cols, (size_t) m->rows * m->cols * sizeof(unsigned int));
+		fprintf(out, "Storage: %s\n", m->placement == PLACEMENT_HEAP && m->mapped_bytes ? "mapped from session file" : placements[m->placement]);
+		fprintf(out, "NUMA nodes: %u%s\n", topology_node_count(), topology_is_fake() ? " (fake)" : "");
+		unsigned long long pages[TOPOLOGY_MAX_NODES];
+		if (topology_matrix_placement(m, pages)) {
+			for (unsigned int n = 0; n < topology_node_count(); ++n) {
+				fprintf(out, "node %u: %llu pages\n", n, pages[n]);
+			}
+		}
+	}
+	else if (strncmp(cmd->cmds[0], "pack", strlen("pack") + 1) == 0
+		&& cmd->num_cmds == 3) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		Bit_Matrix_t* b = NULL;
+		bool is_new = false;
+		if (mat1_idx < 0 || !get_bit_result(cmd->cmds[2], mats[mat1_idx]->rows, mats[mat1_idx]->cols, &b, &is_new)
+			|| !pack_matrix(mats[mat1_idx], b)) {
+			fprintf(out, "Pack Failed\n");
+			if (is_new) {
+				destroy_bit_matrix(&b);
+			}
+			return;
+		}
+		if (is_new && !publish_bit_matrix(b)) {
+			fprintf(out, "Failed to add the bit matrix to the array.\n");
+			destroy_bit_matrix(&b);
+			return;
+		}
+		fprintf(out, "Matrix (%s) is packed into Bit Matrix (%s)\n", cmd->cmds[1], cmd->cmds[2]);
+	}
+	else if (strncmp(cmd->cmds[0], "unpack", strlen("unpack") + 1) == 0
+		&& cmd->num_cmds == 3) {
+		int bit_idx = find_bit_matrix_given_name(cmd->cmds[1]);
+		if (bit_idx < 0) {
+			fprintf(out, "Unpack Failed\n");
+			return;
+		}
+		Bit_Matrix_t* b = bit_mats[bit_idx];
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[2]);
+		if (mat1_idx >= 0 && mats[mat1_idx]->rows == b->rows && mats[mat1_idx]->cols == b->cols) {
+			unpack_bit_matrix(b, mats[mat1_idx]);
+		}
+		else {
+			Matrix_t* m = NULL;
+			if (!create_matrix(&m, cmd->cmds[2], b->rows, b->cols) || !unpack_bit_matrix(b, m)) {
+				fprintf(out, "Unpack Failed\n");
+				destroy_matrix(&m);
+				return;
+			}
+			int add_result = publish_matrix(ctx, m);
+			if (add_result < 0 || add_result > 9) {
+				fprintf(out, "Failed to add the matrix to the array.\n");
+				return;
+			}
+		}
+		fprintf(out, "Bit Matrix (%s) is unpacked into Matrix (%s)\n", cmd->cmds[1], cmd->cmds[2]);
+	}
+	else if (strncmp(cmd->cmds[0], "bitop", strlen("bitop") + 1) == 0
+		&& cmd->num_cmds == 5) {
+		Matrix_Op_t op;
+		int a_idx = find_bit_matrix_given_name(cmd->cmds[2]);
+		int b_idx = find_bit_matrix_given_name(cmd->cmds[3]);
+		if (!matrix_op_from_name(cmd->cmds[1], &op) || a_idx < 0 || b_idx < 0) {
+			fprintf(out, "Bitop Failed\n");
+			return;
+		}
+		Bit_Matrix_t* c = NULL;
+		bool is_new = false;
+		if (!get_bit_result(cmd->cmds[4], bit_mats[a_idx]->rows, bit_mats[a_idx]->cols, &c, &is_new)
+			|| !bitwise_bit_matrices(bit_mats[a_idx], bit_mats[b_idx], c, op)) {
+			fprintf(out, "Bitop Failed\n");
+			if (is_new) {
+				destroy_bit_matrix(&c);
+			}
+			return;
+		}
+		if (is_new && !publish_bit_matrix(c)) {
+			fprintf(out, "Failed to add the bit matrix to the array.\n");
+			destroy_bit_matrix(&c);
+			return;
+		}
+		fprintf(out, "Bit Matrix (%s) = %s %s %s\n", cmd->cmds[4], cmd->cmds[2], cmd->cmds[1], cmd->cmds[3]);
+	}
+	else if (strncmp(cmd->cmds[0], "bitnot", strlen("bitnot") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int bit_idx = find_bit_matrix_given_name(cmd->cmds[1]);
+		if (bit_idx < 0 || !not_bit_matrix(bit_mats[bit_idx])) {
+			fprintf(out, "Bitnot Failed\n");
+			return;
+		}
+		fprintf(out, "Bit Matrix (%s) is inverted\n", cmd->cmds[1]);
+	}
+	else if (strncmp(cmd->cmds[0], "popcount", strlen("popcount") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int bit_idx = find_bit_matrix_given_name(cmd->cmds[1]);
+		if (bit_idx < 0) {
+			fprintf(out, "Popcount Failed\n");
+			return;
+		}
+		Bit_Matrix_t* b = bit_mats[bit_idx];
+		unsigned int* row_counts = calloc(b->rows, sizeof(unsigned int));
+		if (!row_counts) {
+			fprintf(out, "Popcount Failed\n");
+			return;
+		}
+		const unsigned long long total = count_bit_matrix(b, row_counts);
+		fprintf(out, "Set cells in Bit Matrix (%s) = %llu\n", b->name, total);
+		for (unsigned int i = 0; i < b->rows; ++i) {
+			fprintf(out, "row %u: %u\n", i, row_counts[i]);
+		}
+		free(row_counts);
+	}
+	else if (strncmp(cmd->cmds[0], "bitshift", strlen("bitshift") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int bit_idx = find_bit_matrix_given_name(cmd->cmds[1]);
+		const unsigned int shift_value = strtoul(cmd->cmds[3], NULL, 0);
+		if (bit_idx < 0 || strlen(cmd->cmds[2]) != 1 || !shift_bit_matrix(bit_mats[bit_idx], cmd->cmds[2][0], shift_value)) {
+			fprintf(out, "Bitshift Failed\n");
+			return;
+		}
+		fprintf(out, "Bit Matrix (%s) is shifted %s %u\n", cmd->cmds[1], cmd->cmds[2], shift_value);
+	}
+	else if (strncmp(cmd->cmds[0], "bitmul", strlen("bitmul") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int a_idx = find_bit_matrix_given_name(cmd->cmds[1]);
+		int b_idx = find_bit_matrix_given_name(cmd->cmds[2]);
+		if (a_idx < 0 || b_idx < 0 || strncmp(cmd->cmds[3], cmd->cmds[1], MATRIX_NAME_LEN) == 0
+			|| strncmp(cmd->cmds[3], cmd->cmds[2], MATRIX_NAME_LEN) == 0) {
+			fprintf(out, "Bitmul Failed\n");
+			return;
+		}
+		Bit_Matrix_t* c = NULL;
+		bool is_new = false;
+		if (!get_bit_result(cmd->cmds[3], bit_mats[a_idx]->rows, bit_mats[b_idx]->cols, &c, &is_new)
+			|| !multiply_bit_matrices(bit_mats[a_idx], bit_mats[b_idx], c)) {
+			fprintf(out, "Bitmul Failed\n");
+			if (is_new) {
+				destroy_bit_matrix(&c);
+			}
+			return;
+		}
+		if (is_new && !publish_bit_matrix(c)) {
+			fprintf(out, "Failed to add the bit matrix to the array.\n");
+			destroy_bit_matrix(&c);
+			return;
+		}
+		fprintf(out, "Bit Matrix (%s) = %s * %s\n", cmd->cmds[3], cmd->cmds[1], cmd->cmds[2]);
+	}
+	else if (strncmp(cmd->cmds[0], "bitdisplay", strlen("bitdisplay") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int bit_idx = find_bit_matrix_given_name(cmd->cmds[1]);
+		if (bit_idx < 0) {
+			fprintf(out, "Bit Matrix (%s) doesn't exist\n", cmd->cmds[1]);
+			return;
+		}
+		print_bit_matrix(out, bit_mats[bit_idx]);
+	}
+	else if (strncmp(cmd->cmds[0], "bitwrite", strlen("bitwrite") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int bit_idx = find_bit_matrix_given_name(cmd->cmds[1]);
+		if (bit_idx < 0 || !write_bit_matrix(bit_mats[bit_idx]->name, bit_mats[bit_idx])) {
+			fprintf(out, "Bitwrite Failed\n");
+			return;
+		}
+		fprintf(out, "Bit Matrix (%s) is wrote out to the filesystem\n", cmd->cmds[1]);
+	}
+	else if (strncmp(cmd->cmds[0], "bitread", strlen("bitread") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		Bit_Matrix_t* b = NULL;
+		if (!read_bit_matrix(cmd->cmds[1], &b)) {
+			fprintf(out, "Bitread Failed\n");
+			return;
+		}
+		if (!publish_bit_matrix(b)) {
+			fprintf(out, "Failed to add the bit matrix to the array.\n");
+			destroy_bit_matrix(&b);
+			return;
+		}
+		fprintf(out, "Bit Matrix (%s) is read from the filesystem\n", b->name);
+	}
+	else if (strncmp(cmd->cmds[0], "convolve", strlen("convolve") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		int mat2_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[2]);
+		if (mat1_idx < 0 || mat2_idx < 0) {
+			fprintf(out, "Convolve Failed\n");
+			return;
+		}
+		bool is_new = false;
+		Matrix_t* copy_to = NULL;
+		Matrix_t* c = get_filter_result(mats, num_mats, cmd->cmds[3], mats[mat1_idx], mats[mat2_idx], &is_new, &copy_to);
+		if (!c || !convolve_matrix(mats[mat1_idx], mats[mat2_idx], c)) {
+			fprintf(out, "Convolve Failed\n");
+			if (is_new) {
+				destroy_matrix(&c);
+			}
+			return;
+		}
+		if (!store_filter_result(ctx, c, is_new, copy_to)) {
+			fprintf(out, "Failed to add matrix to array.\n");
+			return;
+		}
+		fprintf(out, "Matrix (%s) = %s convolved with %s\n", cmd->cmds[3], cmd->cmds[1], cmd->cmds[2]);
+	}
+	else if (strncmp(cmd->cmds[0], "stencil", strlen("stencil") + 1) == 0
+		&& cmd->num_cmds == 6) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		Stencil_Op_t op;
+		const unsigned int height = strtoul(cmd->cmds[3], NULL, 0);
+		const unsigned int width = strtoul(cmd->cmds[4], NULL, 0);
+		if (mat1_idx < 0 || !stencil_op_from_name(cmd->cmds[2], &op)) {
+			fprintf(out, "Stencil Failed\n");
+			return;
+		}
+		bool is_new = false;
+		Matrix_t* copy_to = NULL;
+		Matrix_t* c = get_filter_result(mats, num_mats, cmd->cmds[5], mats[mat1_idx], NULL, &is_new, &copy_to);
+		if (!c || !stencil_matrix(mats[mat1_idx], op, height, width, c)) {
+			fprintf(out, "Stencil Failed\n");
+			if (is_new) {
+				destroy_matrix(&c);
+			}
+			return;
+		}
+		if (!store_filter_result(ctx, c, is_new, copy_to)) {
+			fprintf(out, "Failed to add matrix to array.\n");
+			return;
+		}
+		fprintf(out, "Matrix (%s) = %s %ux%u of %s\n", cmd->cmds[5], cmd->cmds[2], height, width, cmd->cmds[1]);
+	}
+	else if (strncmp(cmd->cmds[0], "stencil-bench", strlen("stencil-bench") + 1) == 0
+		&& cmd->num_cmds == 3) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		int mat2_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[2]);
+		Stencil_Bench_t bench = {0};
+		if (mat1_idx < 0 || mat2_idx < 0 || !benchmark_convolve(mats[mat1_idx], mats[mat2_idx], &bench)) {
+			fprintf(out, "Stencil Benchmark Failed\n");
+			return;
+		}
+		fprintf(out, "Tiled %s: %f s\n", bench.separable ? "(separable)" : "(direct)", bench.tiled_seconds);
+		fprintf(out, "Reference: %f s\n", bench.reference_seconds);
+		fprintf(out, "Speedup: %.1fx, results %s\n", bench.tiled_seconds > 0 ? bench.reference_seconds / bench.tiled_seconds : 0,
+			bench.match ? "match" : "DIFFER");
+	}
+	else if (strncmp(cmd->cmds[0], "sort", strlen("sort") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		if (mat1_idx < 0 || !sort_matrix(mats[mat1_idx])) {
+			fprintf(out, "Sort Failed\n");
+			return;
+		}
+		fprintf(out, "Matrix (%s) is sorted\n", cmd->cmds[1]);
+	}
+	else if (strncmp(cmd->cmds[0], "sortrows", strlen("sortrows") + 1) == 0
+		&& cmd->num_cmds == 3) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		const unsigned int col = strtoul(cmd->cmds[2], NULL, 0);
+		if (mat1_idx < 0 || !sort_matrix_rows(mats[mat1_idx], col)) {
+			fprintf(out, "Sortrows Failed\n");
+			return;
+		}
+		fprintf(out, "Matrix (%s) rows are sorted by column %u\n", cmd->cmds[1], col);
+	}
+	else if (strncmp(cmd->cmds[0], "percentile", strlen("percentile") + 1) == 0
+		&& cmd->num_cmds == 3) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		const double p = strtod(cmd->cmds[2], NULL);
+		unsigned int value = 0;
+		if (mat1_idx < 0 || !percentile_matrix(mats[mat1_idx], p, &value)) {
+			fprintf(out, "Percentile Failed\n");
+			return;
+		}
+		fprintf(out, "Percentile %g of Matrix (%s) = %u\n", p, cmd->cmds[1], value);
+	}
+	else if (strncmp(cmd->cmds[0], "rangesum", strlen("rangesum") + 1) == 0
+		&& cmd->num_cmds == 6) {
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[1]);
+		const unsigned int r0 = strtoul(cmd->cmds[2], NULL, 0);
+		const unsigned int c0 = strtoul(cmd->cmds[3], NULL, 0);
+		const unsigned int r1 = strtoul(cmd->cmds[4], NULL, 0);
+		const unsigned int c1 = strtoul(cmd->cmds[5], NULL, 0);
+		unsigned long long sum = 0;
+		if (mat1_idx < 0 || !range_sum_matrix(mats[mat1_idx], r0, c0, r1, c1, &sum)) {
+			fprintf(out, "Rangesum Failed\n");
+			return;
+		}
+		fprintf(out, "Sum of Matrix (%s) over (%u,%u) to (%u,%u) = %llu\n", cmd->cmds[1], r0, c0, r1, c1, sum);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-create", strlen("batch-create") + 1) == 0
+		&& cmd->num_cmds == 5) {
+		Matrix_Batch_t* b = NULL;
+		const unsigned int count = strtoul(cmd->cmds[2], NULL, 0);
+		const unsigned int rows = strtoul(cmd->cmds[3], NULL, 0);
+		const unsigned int cols = strtoul(cmd->cmds[4], NULL, 0);
+		if (!create_batch(&b, cmd->cmds[1], count, rows, cols)) {
+			fprintf(out, "Batch Create Failed\n");
+			return;
+		}
+		if (!publish_batch(b)) {
+			fprintf(out, "Failed to add the batch to the array.\n");
+			destroy_batch(&b);
+			return;
+		}
+		fprintf(out, "Created Batch (%s) of %u matrices (%u,%u)\n", b->name, count, rows, cols);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-random", strlen("batch-random") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int batch_idx = find_batch_given_name(cmd->cmds[1]);
+		const unsigned int start_range = strtoul(cmd->cmds[2], NULL, 0);
+		const unsigned int end_range = strtoul(cmd->cmds[3], NULL, 0);
+		if (batch_idx < 0 || !random_batch(batches[batch_idx], start_range, end_range)) {
+			fprintf(out, "Batch Random Failed\n");
+			return;
+		}
+		fprintf(out, "Batch (%s) is randomized between %u %u\n", cmd->cmds[1], start_range, end_range);
+	}
+	else if ((strncmp(cmd->cmds[0], "batch-add", strlen("batch-add") + 1) == 0
+		|| strncmp(cmd->cmds[0], "batch-mul", strlen("batch-mul") + 1) == 0) && cmd->num_cmds == 4) {
+		const bool multiply = strncmp(cmd->cmds[0], "batch-mul", strlen("batch-mul") + 1) == 0;
+		int a_idx = find_batch_given_name(cmd->cmds[1]);
+		int b_idx = find_batch_given_name(cmd->cmds[2]);
+		if (a_idx < 0 || b_idx < 0 || (multiply && (strncmp(cmd->cmds[3], cmd->cmds[1], MATRIX_NAME_LEN) == 0
+			|| strncmp(cmd->cmds[3], cmd->cmds[2], MATRIX_NAME_LEN) == 0))) {
+			fprintf(out, "Batch %s Failed\n", multiply ? "Multiply" : "Add");
+			return;
+		}
+		Matrix_Batch_t* a = batches[a_idx];
+		Matrix_Batch_t* b = batches[b_idx];
+		Matrix_Batch_t* c = NULL;
+		bool is_new = false;
+		if (!get_batch_result(cmd->cmds[3], a->count, a->rows, multiply ? b->cols : a->cols, &c, &is_new)
+			|| !(multiply ? multiply_batches(a, b, c) : add_batches(a, b, c))) {
+			fprintf(out, "Batch %s Failed\n", multiply ? "Multiply" : "Add");
+			if (is_new) {
+				destroy_batch(&c);
+			}
+			return;
+		}
+		if (is_new && !publish_batch(c)) {
+			fprintf(out, "Failed to add the batch to the array.\n");
+			destroy_batch(&c);
+			return;
+		}
+		fprintf(out, "Batch (%s) = %s %s %s\n", cmd->cmds[3], cmd->cmds[1], multiply ? "*" : "+", cmd->cmds[2]);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-shift", strlen("batch-shift") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int batch_idx = find_batch_given_name(cmd->cmds[1]);
+		const unsigned int shift_value = strtoul(cmd->cmds[3], NULL, 0);
+		if (batch_idx < 0 || strlen(cmd->cmds[2]) != 1 || !shift_batch(batches[batch_idx], cmd->cmds[2][0], shift_value)) {
+			fprintf(out, "Batch Shift Failed\n");
+			return;
+		}
+		fprintf(out, "Batch (%s) is shifted %s %u\n", cmd->cmds[1], cmd->cmds[2], shift_value);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-sum", strlen("batch-sum") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int batch_idx = find_batch_given_name(cmd->cmds[1]);
+		if (batch_idx < 0) {
+			fprintf(out, "Batch Sum Failed\n");
+			return;
+		}
+		Matrix_Batch_t* b = batches[batch_idx];
+		unsigned long long* sums = calloc(b->count, sizeof(unsigned long long));
+		if (!sums || !sum_batch(b, sums)) {
+			fprintf(out, "Batch Sum Failed\n");
+			free(sums);
+			return;
+		}
+		unsigned long long total = 0;
+		for (unsigned int k = 0; k < b->count; ++k) {
+			total += sums[k];
+		}
+		fprintf(out, "Sum of Batch (%s) = %llu\n", b->name, total);
+		/* a batch can hold millions of matrices, only the first few are listed */
+		for (unsigned int k = 0; k < b->count && k < 10; ++k) {
+			fprintf(out, "matrix %u: %llu\n", k, sums[k]);
+		}
+		free(sums);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-equal", strlen("batch-equal") + 1) == 0
+		&& cmd->num_cmds == 3) {
+		int a_idx = find_batch_given_name(cmd->cmds[1]);
+		int b_idx = find_batch_given_name(cmd->cmds[2]);
+		if (a_idx < 0 || b_idx < 0 || batches[a_idx]->count != batches[b_idx]->count
+			|| batches[a_idx]->rows != batches[b_idx]->rows || batches[a_idx]->cols != batches[b_idx]->cols) {
+			fprintf(out, "Batch Equal Failed\n");
+			return;
+		}
+		unsigned char* equal = calloc(batches[a_idx]->count, sizeof(unsigned char));
+		if (!equal) {
+			fprintf(out, "Batch Equal Failed\n");
+			return;
+		}
+		unsigned int matches = equal_batches(batches[a_idx], batches[b_idx], equal);
+		fprintf(out, "%u of %u matrices of Batch (%s) and Batch (%s) are equal\n", matches, batches[a_idx]->count,
+			cmd->cmds[1], cmd->cmds[2]);
+		free(equal);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-get", strlen("batch-get") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int batch_idx = find_batch_given_name(cmd->cmds[1]);
+		const unsigned int index = strtoul(cmd->cmds[2], NULL, 0);
+		if (batch_idx < 0 || index >= batches[batch_idx]->count) {
+			fprintf(out, "Batch Get Failed\n");
+			return;
+		}
+		Matrix_Batch_t* b = batches[batch_idx];
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[3]);
+		if (mat1_idx >= 0 && mats[mat1_idx]->rows == b->rows && mats[mat1_idx]->cols == b->cols) {
+			batch_get_matrix(b, index, mats[mat1_idx]);
+		}
+		else {
+			Matrix_t* m = NULL;
+			if (!create_matrix(&m, cmd->cmds[3], b->rows, b->cols) || !batch_get_matrix(b, index, m)) {
+				fprintf(out, "Batch Get Failed\n");
+				destroy_matrix(&m);
+				return;
+			}
+			int add_result = publish_matrix(ctx, m);
+			if (add_result < 0 || add_result > 9) {
+				fprintf(out, "Failed to add the matrix to the array.\n");
+				return;
+			}
+		}
+		fprintf(out, "Matrix (%s) = Batch (%s) matrix %u\n", cmd->cmds[3], cmd->cmds[1], index);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-set", strlen("batch-set") + 1) == 0
+		&& cmd->num_cmds == 4) {
+		int batch_idx = find_batch_given_name(cmd->cmds[1]);
+		const unsigned int index = strtoul(cmd->cmds[2], NULL, 0);
+		int mat1_idx = find_matrix_given_name(mats,num_mats,cmd->cmds[3]);
+		if (batch_idx < 0 || mat1_idx < 0 || !batch_set_matrix(batches[batch_idx], index, mats[mat1_idx])) {
+			fprintf(out, "Batch Set Failed\n");
+			return;
+		}
+		fprintf(out, "Batch (%s) matrix %u = Matrix (%s)\n", cmd->cmds[1], index, cmd->cmds[3]);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-write", strlen("batch-write") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		int batch_idx = find_batch_given_name(cmd->cmds[1]);
+		if (batch_idx < 0 || !write_batch(batches[batch_idx]->name, batches[batch_idx])) {
+			fprintf(out, "Batch Write Failed\n");
+			return;
+		}
+		fprintf(out, "Batch (%s) is wrote out to the filesystem\n", cmd->cmds[1]);
+	}
+	else if (strncmp(cmd->cmds[0], "batch-read", strlen("batch-read") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		Matrix_Batch_t* b = NULL;
+		if (!read_batch(cmd->cmds[1], &b)) {
+			fprintf(out, "Batch Read Failed\n");
+			return;
+		}
+		if (!publish_batch(b)) {
+			fprintf(out, "Failed to add the batch to the array.\n");
+			destroy_batch(&b);
+			return;
+		}
+		fprintf(out, "Batch (%s) is read from the filesystem\n", b->name);
+	}
+	else if (strncmp(cmd->cmds[0], "save-session", strlen("save-session") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		if (! save_session(cmd->cmds[1], ctx)) {
+			fprintf(out, "Session save failed\n");
+			return;
+		}
+		fprintf(out, "Session saved to %s\n", cmd->cmds[1]);
+	}
+	else if (strncmp(cmd->cmds[0], "load-session", strlen("load-session") + 1) == 0
+		&& cmd->num_cmds == 2) {
+		unsigned int restored = 0;
+		Matrix_Status_t load_status = load_session(cmd->cmds[1], ctx, &restored);
+		if (load_status != MATRIX_OK) {
+			fprintf(out, "Session load failed: %s\n", matrix_status_string(load_status));
+			return;
+		}
+		fprintf(out, "Restored %u matrices from %s\n", restored, cmd->cmds[1]);
 	}
 	else {
-		printf("Not a command in this application\n");
+		fprintf(out, "Not a command in this application\n");
 	}
 
 }
@@ -300,7 +1016,7 @@ unsigned int find_matrix_given_name (Matrix_t** mats, unsigned int num_mats, con
 	}
 
 	for (int i = 0; i < num_mats; ++i) {
-		if (mats[i] != NULL && strncmp(mats[i]->name,target,strlen(mats[i]->name)) == 0) {
+		if (mats[i] != NULL && strncmp(mats[i]->name,target,MATRIX_NAME_LEN) == 0) {
 			return i;
 		}
 	}
@@ -308,22 +1024,200 @@ unsigned int find_matrix_given_name (Matrix_t** mats, unsigned int num_mats, con
 }
 
 	/*
-		PURPOSE: This function will iterate over the array of matrices and de-allocate the memory set aside for each matrix inside of the array, and then de-allocate the array. 
-		INPUTS: The input are: **mats -> double pointer that references an array holding all of the matrices that are generated through runtime of this program, and num_mats is the counter of how many matrices theere are. 
-		RETURNS: This function is a void function, meaning that it returns nothing. It does work on some sort of passed in data, and manipulates it through pointers, thus directly modifying the memory. 
+		PURPOSE: This function looks up a bit matrix by name.
+		INPUTS: target -> the name of the bit matrix.
+		RETURNS: the position of the bit matrix in bit_mats, or -1 if there is none with that name.
 	*/
 
-void destroy_remaining_heap_allocations(Matrix_t **mats, unsigned int num_mats) {
+int find_bit_matrix_given_name (const char* target) {
 
-	if(!mats)
-		return; 
+	if(!target || strlen(target) == 0)
+		return -1;
 
-	if(num_mats <= 0)
-		return; 
+	for (int i = 0; i < NUM_BIT_MATS; ++i) {
+		if (bit_mats[i] != NULL && strncmp(bit_mats[i]->name,target,MATRIX_NAME_LEN) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+	/*
+		PURPOSE: This function stores a bit matrix in bit_mats, replacing and destroying any bit matrix with the same name, otherwise
+			taking a free slot. Unlike the dense array nothing is evicted, the bit matrix is refused when the table is full.
+		INPUTS: m -> the bit matrix, owned by the table on success.
+		RETURNS: true on success, false on invalid parameters or when the table is full.
+	*/
+
+bool publish_bit_matrix (Bit_Matrix_t* m) {
+
+	if(!m)
+		return false;
+
+	scheduler_begin_exclusive();
+	int slot = find_bit_matrix_given_name(m->name);
+	if (slot >= 0) {
+		destroy_bit_matrix(&bit_mats[slot]);
+	}
+	for (int i = 0; slot < 0 && i < NUM_BIT_MATS; ++i) {
+		if (bit_mats[i] == NULL) {
+			slot = i;
+		}
+	}
+	if (slot >= 0) {
+		bit_mats[slot] = m;
+	}
+	scheduler_end_exclusive();
+	return slot >= 0;
+}
+
+	/*
+		PURPOSE: This function finds the bit matrix a command stores its result in. An existing bit matrix of the right dimensions is
+			reused in place, otherwise a new one is created that the caller must publish or destroy.
+		INPUTS: name -> the name of the result. rows, cols -> the dimensions of the result. result -> receives the bit matrix.
+			is_new -> set to true when the bit matrix was created here.
+		RETURNS: true on success, false on invalid parameters or when the matrix could not be created.
+	*/
+
+bool get_bit_result (const char* name, unsigned int rows, unsigned int cols, Bit_Matrix_t** result, bool* is_new) {
+
+	if(!name || !result || !is_new)
+		return false;
+
+	int idx = find_bit_matrix_given_name(name);
+	if (idx >= 0 && bit_mats[idx]->rows == rows && bit_mats[idx]->cols == cols) {
+		*result = bit_mats[idx];
+		*is_new = false;
+		return true;
+	}
+	*is_new = create_bit_matrix(result, name, rows, cols);
+	return *is_new;
+}
+
+	/*
+		PURPOSE: This function finds the matrix a filter command stores its result in. An existing matrix of the same dimensions as the
+			source is reused in place. The filters cannot write over their own inputs, so when the result is one of them a scratch matrix is
+			created instead and copy_to is set to the input it must be copied back into. Otherwise a new matrix is created.
+		INPUTS: mats -> the matrix array. num_mats -> the size of the array. name -> the name of the result. src -> the filtered matrix.
+			kernel -> the kernel, or NULL. is_new -> set to true when the matrix was created here. copy_to -> receives the input the
+			result is copied back into, or NULL.
+		RETURNS: the matrix to compute into, or NULL when it could not be created.
+	*/
+
+Matrix_t* get_filter_result (Matrix_t** mats, unsigned int num_mats, const char* name, Matrix_t* src, Matrix_t* kernel,
+			bool* is_new, Matrix_t** copy_to) {
+
+	if(!mats || !name || !src || !is_new || !copy_to)
+		return NULL;
+
+	*is_new = false;
+	*copy_to = NULL;
+	int idx = find_matrix_given_name(mats, num_mats, name);
+	if (idx >= 0 && mats[idx]->rows == src->rows && mats[idx]->cols == src->cols) {
+		if (mats[idx] != src && mats[idx] != kernel) {
+			return mats[idx];
+		}
+		*copy_to = mats[idx];
+	}
+	Matrix_t* c = NULL;
+	if (!create_matrix(&c, name, src->rows, src->cols)) {
+		*copy_to = NULL;
+		return NULL;
+	}
+	*is_new = true;
+	return c;
+}
+
+	/*
+		PURPOSE: This function puts the result of a filter command where get_filter_result decided it goes: copied back into an input,
+			added to the array, or nothing to do when it was computed in place.
+		INPUTS: ctx -> the matrix context. c, is_new, copy_to -> as returned by get_filter_result.
+		RETURNS: true on success, false when the result could not be stored, in which case it has been destroyed.
+	*/
+
+bool store_filter_result (Matrix_Context_t* ctx, Matrix_t* c, bool is_new, Matrix_t* copy_to) {
+
+	if (copy_to) {
+		bool copied = duplicate_matrix(c, copy_to);
+		destroy_matrix(&c);
+		return copied;
+	}
+	if (is_new) {
+		int add_result = publish_matrix(ctx, c);
+		if (add_result < 0 || add_result > 9) {
+			destroy_matrix(&c);
+			return false;
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function looks up a batch by name.
+		INPUTS: target -> the name of the batch.
+		RETURNS: the position of the batch in batches, or -1 if there is none with that name.
+	*/
+
+int find_batch_given_name (const char* target) {
+
+	if(!target || strlen(target) == 0)
+		return -1;
+
+	for (int i = 0; i < NUM_BATCHES; ++i) {
+		if (batches[i] != NULL && strncmp(batches[i]->name,target,MATRIX_NAME_LEN) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+	/*
+		PURPOSE: This function stores a batch in batches like publish_bit_matrix, replacing a batch with the same name or taking a free slot.
+		INPUTS: b -> the batch, owned by the table on success.
+		RETURNS: true on success, false on invalid parameters or when the table is full.
+	*/
+
+bool publish_batch (Matrix_Batch_t* b) {
+
+	if(!b)
+		return false;
+
+	scheduler_begin_exclusive();
+	int slot = find_batch_given_name(b->name);
+	if (slot >= 0) {
+		destroy_batch(&batches[slot]);
+	}
+	for (int i = 0; slot < 0 && i < NUM_BATCHES; ++i) {
+		if (batches[i] == NULL) {
+			slot = i;
+		}
+	}
+	if (slot >= 0) {
+		batches[slot] = b;
+	}
+	scheduler_end_exclusive();
+	return slot >= 0;
+}
+
+	/*
+		PURPOSE: This function finds the batch a command stores its result in, reusing an existing batch of the right size and shape in
+			place, otherwise creating a new one that the caller must publish or destroy.
+		INPUTS: name -> the name of the result. count, rows, cols -> the size and shape of the result. result -> receives the batch.
+			is_new -> set to true when the batch was created here.
+		RETURNS: true on success, false on invalid parameters or when the batch could not be created.
+	*/
+
+bool get_batch_result (const char* name, unsigned int count, unsigned int rows, unsigned int cols, Matrix_Batch_t** result, bool* is_new) {
+
+	if(!name || !result || !is_new)
+		return false;
 
-	for(int i = 0; i < num_mats; i++){
-		if(mats[i] != NULL)
-			free(mats[i]->data);
-			free(mats[i]);
+	int idx = find_batch_given_name(name);
+	if (idx >= 0 && batches[idx]->count == count && batches[idx]->rows == rows && batches[idx]->cols == cols) {
+		*result = batches[idx];
+		*is_new = false;
+		return true;
 	}
+	*is_new = create_batch(result, name, count, rows, cols);
+	return *is_new;
 }
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -11,74 +12,110 @@
 
 
 #include "matrix.h"
+#include "topology.h"
 
 
 #define MAX_CMD_COUNT 50
 
+/* applies expr to n cells of x in place and notes in changed whether any of them got a new value */
+#define UPDATE_CELLS(n, expr) \
+	for (size_t i = 0; i < (n); ++i) { \
+		const unsigned int y = (expr); \
+		changed |= y ^ x[i]; \
+		x[i] = y; \
+	}
+
 /*protected functions*/
-void load_matrix (Matrix_t* m, unsigned int* data);
+static Matrix_Status_t read_matrix_field (int fd, void* buffer, size_t len);
+static bool scalar_op_cells (unsigned int* x, size_t n, Matrix_Op_t op, unsigned int value);
+static bool vector_op_cells (unsigned int* x, const unsigned int* v, size_t n, Matrix_Op_t op);
+static bool track_matrix_file (Matrix_t* m, const char* filename, const struct stat* st);
+static bool write_matrix_dirty_blocks (const char* matrix_output_filename, Matrix_t* m);
 
 /* 
  * PURPOSE: instantiates a new matrix with the passed name, rows, cols 
  * INPUTS: 
- *	name the name of the matrix limited to 50 characters 
+ *	name the name of the matrix limited to MATRIX_NAME_LEN - 1 characters 
  *  rows the number of rows the matrix
  *  cols the number of cols the matrix
  * RETURN:
- *  If no errors occurred during instantiation then true
- *  else false for an error in the process.
+ *  MATRIX_OK if no errors occurred during instantiation,
+ *  MATRIX_ERR_ARGS for invalid parameters or MATRIX_ERR_NO_MEMORY when memory ran out.
  *
  **/
 
-bool create_matrix (Matrix_t** new_matrix, const char* name, const unsigned int rows,
+Matrix_Status_t create_matrix_status (Matrix_t** new_matrix, const char* name, const unsigned int rows,
 						const unsigned int cols) {
 
-	if(new_matrix == NULL){
-		printf("Passed in matrix was not initialized correctly.\n");
-		return false; 
+	if(new_matrix == NULL || name == NULL){
+		return MATRIX_ERR_ARGS; 
 	}
 
-	if(strlen(name) == 0){
-		printf("No name provided for creation.\n");
-		return false; 
+	const size_t len = strlen(name) + 1; 
+	if(len == 1 || len > MATRIX_NAME_LEN){
+		return MATRIX_ERR_ARGS; 
 	}
 
 	if(rows <= 0 || cols <= 0){
-		printf("Invalid amount of rows and / or columns.\n");
-		return false; 
+		return MATRIX_ERR_ARGS; 
 	}
 
 	*new_matrix = calloc(1,sizeof(Matrix_t));
 	if (!(*new_matrix)) {
-		return false;
-	}
-	(*new_matrix)->data = calloc(rows * cols,sizeof(unsigned int));
-	if (!(*new_matrix)->data) {
-		return false;
+		return MATRIX_ERR_NO_MEMORY;
 	}
 	(*new_matrix)->rows = rows;
 	(*new_matrix)->cols = cols;
-	unsigned int len = strlen(name) + 1; 
-	if (len > MATRIX_NAME_LEN) {
-		return false;
+	pthread_mutex_init(&(*new_matrix)->prefix_lock, NULL);
+	/* large matrices are placed across NUMA nodes, everything else comes from the heap */
+	if (!topology_alloc_matrix(*new_matrix)) {
+		(*new_matrix)->data = calloc((size_t) rows * cols,sizeof(unsigned int));
 	}
-	strncpy((*new_matrix)->name,name,len);
-	return true;
+	if (!(*new_matrix)->data) {
+		pthread_mutex_destroy(&(*new_matrix)->prefix_lock);
+		free(*new_matrix);
+		*new_matrix = NULL;
+		return MATRIX_ERR_NO_MEMORY;
+	}
+	memcpy((*new_matrix)->name,name,len);
+	return MATRIX_OK;
 
+}
+
+	/*
+		PURPOSE: This function is create_matrix_status for callers that only need to know whether it worked.
+		INPUTS: new_matrix, name, rows, cols -> as for create_matrix_status.
+		RETURNS: true on success, false on invalid parameters or when memory ran out.
+	*/
+
+bool create_matrix (Matrix_t** new_matrix, const char* name, const unsigned int rows,
+						const unsigned int cols) {
+
+	return create_matrix_status(new_matrix, name, rows, cols) == MATRIX_OK;
 }
 
 	/*
 		PURPOSE: This function will, given a matrix, free up its memory usage and remove from the runtime of the program.
 		INPUTS: This function takes in 'm', and 'm' being a matrix that is to be removed from program. 
+			Matrices restored from a session file keep their data in a private mapping, so that is unmapped instead of freed.
 		RETURNS: This function is void, meaning that it returns no value to the caller, that it does some work on passed in data. 
 	*/
 
 void destroy_matrix (Matrix_t** m) {
 	
-	if(!m)
+	if(!m || !(*m))
 		return; 
 
-	free((*m)->data);
+	if ((*m)->mapped_bytes) {
+		munmap((*m)->data, (*m)->mapped_bytes);
+	}
+	else {
+		free((*m)->data);
+	}
+	free((*m)->synced_file);
+	free((*m)->dirty_blocks);
+	free((*m)->prefix_sums);
+	pthread_mutex_destroy(&(*m)->prefix_lock);
 	free(*m);
 	*m = NULL;
 }
@@ -116,11 +153,13 @@ bool duplicate_matrix (Matrix_t* src, Matrix_t* dest) {
 	if (!src) {
 		return false;
 	}
+	if (src->rows != dest->rows || src->cols != dest->cols) {
+		return false;
+	}
 	/*
-	 * copy over data
+	 * copy over data, only the rows that differ are copied and marked
 	 */
-	unsigned int bytesToCopy = sizeof(unsigned int) * src->rows * src->cols;
-	memcpy(dest->data,src->data, bytesToCopy);	
+	update_matrix_data(dest, src->data);
 	return equal_matrices (src,dest);
 }
 
@@ -138,37 +177,31 @@ bool bitwise_shift_matrix (Matrix_t* a, char direction, unsigned int shift) {
 		return false;
 	}
 
-	if(direction != 'l' || direction != 'r')
+	if(direction != 'l' && direction != 'r')
 		return false; 
 
 	if(shift < 0)
 		return false; 
 
-	if (direction == 'l') {
-		unsigned int i = 0;
-		for (; i < a->rows; ++i) {
-			unsigned int j = 0;
-			for (; j < a->cols; ++j) {
-				a->data[i * a->cols + j] = a->data[i * a->cols + j] << shift;
-			}
+	for (unsigned int r = 0; r < a->rows; ++r) {
+		unsigned int* x = &a->data[(size_t) r * a->cols];
+		unsigned int changed = 0;
+		if (direction == 'l') {
+			UPDATE_CELLS(a->cols, x[i] << shift)
 		}
-
-	}
-	else {
-		unsigned int i = 0;
-		for (; i < a->rows; ++i) {
-			unsigned int j = 0;
-			for (; j < a->cols; ++j) {
-				a->data[i * a->cols + j] = a->data[i * a->cols + j] >> shift;
-			}
+		else {
+			UPDATE_CELLS(a->cols, x[i] >> shift)
+		}
+		if (changed) {
+			mark_matrix_dirty(a, r, r + 1);
 		}
 	}
-	
 	return true;
 }
 
 	/*
 		PURPOSE: This function takes two matrices and adds them together and stores the result in a 3rd pre-allocated matrix. 
+			c may be the same matrix as a or b, which accumulates in place without allocating a result matrix.
 		INPUTS: The input are: a -> one of the two matrices to have its content added with the second matrix and stored in the 3rd matrix
 			b -> the second part of the addition command, its contents are taken and added with a's contents
 			c -> the final part of this function, and it just takes the contents of a and b added together and stores it
@@ -183,18 +216,108 @@ bool add_matrices (Matrix_t* a, Matrix_t* b, Matrix_t* c) {
 	if(!a->data || !b->data || !c->data)
 		return false; 
 
-	if (a->rows != b->rows && a->cols != b->cols) {
+	if (a->rows != b->rows || a->cols != b->cols || a->rows != c->rows || a->cols != c->cols) {
 		return false;
 	}
 
-	for (int i = 0; i < a->rows; ++i) {
-		for (int j = 0; j < b->cols; ++j) {
-			c->data[i * a->cols +j] = a->data[i * a->cols + j] + b->data[i * a->cols + j];
+	/* elementwise, so one loop per row the compiler can vectorize; aliasing c with a or b is fine. Only rows that changed are marked */
+	for (unsigned int r = 0; r < c->rows; ++r) {
+		const size_t first = (size_t) r * c->cols;
+		const unsigned int* p = &a->data[first];
+		const unsigned int* q = &b->data[first];
+		unsigned int* x = &c->data[first];
+		unsigned int changed = 0;
+		UPDATE_CELLS(c->cols, p[i] + q[i])
+		if (changed) {
+			mark_matrix_dirty(c, r, r + 1);
 		}
 	}
 	return true;
 }
 
+	/*
+		PURPOSE: This function applies one operation between every cell of a matrix and a constant, writing the result back into the matrix.
+		INPUTS: a -> the matrix updated in place. op -> the operation to apply. value -> the constant right hand operand.
+		RETURNS: true once every cell has been updated, false on invalid parameters.
+	*/
+
+bool scalar_op_matrix (Matrix_t* a, Matrix_Op_t op, unsigned int value) {
+
+	if(!a || !a->data)
+		return false;
+
+	if ((unsigned int) op > MATRIX_OP_MAX)
+		return false;
+
+	/* row by row so only the rows that changed are marked */
+	for (unsigned int r = 0; r < a->rows; ++r) {
+		if (scalar_op_cells(&a->data[(size_t) r * a->cols], a->cols, op, value)) {
+			mark_matrix_dirty(a, r, r + 1);
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function applies one operation between a matrix and a vector in place. A 1 x cols vector is applied to every row,
+			a rows x 1 vector to every column, so cell (i,j) is combined with v[j] or v[i] respectively.
+		INPUTS: a -> the matrix updated in place. v -> the row or column vector. op -> the operation to apply.
+		RETURNS: true once every cell has been updated, false on invalid parameters or when v does not fit a as a row or column vector.
+	*/
+
+bool broadcast_op_matrix (Matrix_t* a, Matrix_t* v, Matrix_Op_t op) {
+
+	if(!a || !v || !a->data || !v->data)
+		return false;
+
+	if ((unsigned int) op > MATRIX_OP_MAX)
+		return false;
+
+	if (v->rows == 1 && v->cols == a->cols) {
+		/* row vector: the same vector kernel runs over every row */
+		for (unsigned int i = 0; i < a->rows; ++i) {
+			if (vector_op_cells(&a->data[(size_t) i * a->cols], v->data, a->cols, op)) {
+				mark_matrix_dirty(a, i, i + 1);
+			}
+		}
+		return true;
+	}
+
+	if (v->cols == 1 && v->rows == a->rows) {
+		/* column vector: each row is a scalar operation with its own constant */
+		for (unsigned int i = 0; i < a->rows; ++i) {
+			if (scalar_op_cells(&a->data[(size_t) i * a->cols], a->cols, op, v->data[i])) {
+				mark_matrix_dirty(a, i, i + 1);
+			}
+		}
+		return true;
+	}
+
+	return false;
+}
+
+	/*
+		PURPOSE: This function maps the name of an elementwise operation as typed by the user to its Matrix_Op_t value.
+		INPUTS: name -> one of add, sub, mul, and, or, xor, min, max. op -> where the matching operation is stored.
+		RETURNS: true if the name is a known operation, false otherwise.
+	*/
+
+bool matrix_op_from_name (const char* name, Matrix_Op_t* op) {
+
+	static const char* names[] = {"add", "sub", "mul", "and", "or", "xor", "min", "max"};
+
+	if(!name || !op)
+		return false;
+
+	for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		if (strncmp(name, names[i], strlen(names[i]) + 1) == 0) {
+			*op = (Matrix_Op_t) i;
+			return true;
+		}
+	}
+	return false;
+}
+
 	/*
 		PURPOSE: This function takes a matrix and outputs it to the screen for the user to see. 
 		INPUTS: The inputs are: m -> the matrix to be iterated over and have its contents displayed to the user
@@ -203,18 +326,29 @@ bool add_matrices (Matrix_t* a, Matrix_t* b, Matrix_t* c) {
 
 void display_matrix (Matrix_t* m) {
 
-	if(!m)
+	print_matrix(stdout, m);
+}
+
+	/*
+		PURPOSE: This function prints a matrix the same way display_matrix does, but to any stream.
+		INPUTS: out -> the stream to print to. m -> the matrix to print.
+		RETURNS: Nothing.
+	*/
+
+void print_matrix (FILE* out, Matrix_t* m) {
+
+	if(!out || !m)
 		return; 
 
-	printf("\nMatrix Contents (%s):\n", m->name);
-	printf("DIM = (%u,%u)\n", m->rows, m->cols);
+	fprintf(out, "\nMatrix Contents (%s):\n", m->name);
+	fprintf(out, "DIM = (%u,%u)\n", m->rows, m->cols);
 	for (int i = 0; i < m->rows; ++i) {
 		for (int j = 0; j < m->cols; ++j) {
-			printf("%u ", m->data[i * m->cols + j]);
+			fprintf(out, "%u ", m->data[i * m->cols + j]);
 		}
-		printf("\n");
+		fprintf(out, "\n");
 	}
-	printf("\n");
+	fprintf(out, "\n");
 
 }
 
@@ -222,186 +356,133 @@ void display_matrix (Matrix_t* m) {
 		PURPOSE: This function is nearly the opposite of the write_matrix function, it will open up a file and read the matrix from it into a matrix in the program, the matrix read from the file
 			is stored in binary format. 
 		INPUTS: The input are: matrix_input_filename -> the filename to be reading the binary-written matrix from.
-			m -> the matrix that will have its contents updated with the content read from the file. 
-		RETURNS: The function returns a bool, true on successful reading of the file; false on invalid input parameters, or if something goes wrong during reading. 
+			m -> receives the matrix read from the file. 
+		RETURNS: MATRIX_OK on success. MATRIX_TORN_FILE when the file was left behind by an interrupted incremental write, the matrix is still
+			read but may mix old and new blocks. MATRIX_ERR_ARGS on invalid parameters, MATRIX_ERR_OPEN when the file could not be opened,
+			MATRIX_ERR_IO when reading it failed, MATRIX_ERR_FORMAT when it is not a matrix file or is cut short and MATRIX_ERR_NO_MEMORY
+			when memory ran out; *m is left untouched on all of these.
 	*/
 
-bool read_matrix (const char* matrix_input_filename, Matrix_t** m) {
+Matrix_Status_t read_matrix_status (const char* matrix_input_filename, Matrix_t** m) {
 	
-	if(strlen(matrix_input_filename) == 0)
-		return false; 
+	if(!matrix_input_filename || strlen(matrix_input_filename) == 0)
+		return MATRIX_ERR_ARGS; 
 
 	if(!m)
-		return false; 
+		return MATRIX_ERR_ARGS; 
 
 	int fd = open(matrix_input_filename,O_RDONLY);
 	if (fd < 0) {
-		printf("FAILED TO OPEN FOR READING\n");
-		if (errno == EACCES ) {
-			perror("DO NOT HAVE ACCESS TO FILE\n");
-		}
-		else if (errno == EADDRINUSE ){
-			perror("FILE ALREADY IN USE\n");
-		}
-		else if (errno == EBADF) {
-			perror("BAD FILE DESCRIPTOR\n");	
-		}
-		else if (errno == EEXIST) {
-			perror("FILE EXIST\n");
-		}
-		return false;
+		return MATRIX_ERR_OPEN;
 	}
 
 	/*read the wrote dimensions and name length*/
 	unsigned int name_len = 0;
 	unsigned int rows = 0;
 	unsigned int cols = 0;
-	
-	if (read(fd,&name_len,sizeof(unsigned int)) != sizeof(unsigned int)) {
-		printf("FAILED TO READING FILE\n");
-		if (errno == EACCES ) {
-			perror("DO NOT HAVE ACCESS TO FILE\n");
-		}
-		else if (errno == EADDRINUSE ){
-			perror("FILE ALREADY IN USE\n");
-		}
-		else if (errno == EBADF) {
-			perror("BAD FILE DESCRIPTOR\n");	
-		}
-		else if (errno == EEXIST) {
-			perror("FILE EXIST\n");
-		}
-		return false;
-	}
-	char name_buffer[50];
-	if (read (fd,name_buffer,sizeof(char) * name_len) != sizeof(char) * name_len) {
-		printf("FAILED TO READ MATRIX NAME\n");
-		if (errno == EACCES ) {
-			perror("DO NOT HAVE ACCESS TO FILE\n");
-		}
-		else if (errno == EADDRINUSE ){
-			perror("FILE ALREADY IN USE\n");
-		}
-		else if (errno == EBADF) {
-			perror("BAD FILE DESCRIPTOR\n");	
-		}
-		else if (errno == EEXIST) {
-			perror("FILE EXIST\n");
-		}
+	char name_buffer[MATRIX_NAME_LEN];
 
-		return false;	
+	Matrix_Status_t status = read_matrix_field(fd, &name_len, sizeof(unsigned int));
+	if (status == MATRIX_OK && (name_len == 0 || name_len > MATRIX_NAME_LEN)) {
+		/* not a matrix file, a bit matrix file starts with its magic tag here */
+		status = MATRIX_ERR_FORMAT;
 	}
-
-	if (read (fd,&rows, sizeof(unsigned int)) != sizeof(unsigned int)) {
-		printf("FAILED TO READ MATRIX ROW SIZE\n");
-		if (errno == EACCES ) {
-			perror("DO NOT HAVE ACCESS TO FILE\n");
-		}
-		else if (errno == EADDRINUSE ){
-			perror("FILE ALREADY IN USE\n");
-		}
-		else if (errno == EBADF) {
-			perror("BAD FILE DESCRIPTOR\n");	
-		}
-		else if (errno == EEXIST) {
-			perror("FILE EXIST\n");
-		}
-
-		return false;
+	if (status == MATRIX_OK) {
+		status = read_matrix_field(fd, name_buffer, name_len);
 	}
-
-	if (read(fd,&cols,sizeof(unsigned int)) != sizeof(unsigned int)) {
-		printf("FAILED TO READ MATRIX COLUMN SIZE\n");
-		if (errno == EACCES ) {
-			perror("DO NOT HAVE ACCESS TO FILE\n");
-		}
-		else if (errno == EADDRINUSE ){
-			perror("FILE ALREADY IN USE\n");
-		}
-		else if (errno == EBADF) {
-			perror("BAD FILE DESCRIPTOR\n");	
-		}
-		else if (errno == EEXIST) {
-			perror("FILE EXIST\n");
-		}
-
-		return false;
+	if (status == MATRIX_OK) {
+		status = read_matrix_field(fd, &rows, sizeof(unsigned int));
+	}
+	if (status == MATRIX_OK) {
+		status = read_matrix_field(fd, &cols, sizeof(unsigned int));
+	}
+	if (status == MATRIX_OK && (rows == 0 || cols == 0)) {
+		status = MATRIX_ERR_FORMAT;
+	}
+	if (status != MATRIX_OK) {
+		close(fd);
+		return status;
 	}
+	name_buffer[name_len - 1] = '\0';
 
-	unsigned int numberOfDataBytes = rows * cols * sizeof(unsigned int);
-	unsigned int *data = calloc(rows * cols, sizeof(unsigned int));
-	if (read(fd,data,numberOfDataBytes) != numberOfDataBytes) {
-		printf("FAILED TO READ MATRIX DATA\n");
-		if (errno == EACCES ) {
-			perror("DO NOT HAVE ACCESS TO FILE\n");
-		}
-		else if (errno == EADDRINUSE ){
-			perror("FILE ALREADY IN USE\n");
-		}
-		else if (errno == EBADF) {
-			perror("BAD FILE DESCRIPTOR\n");	
-		}
-		else if (errno == EEXIST) {
-			perror("FILE EXIST\n");
-		}
+	struct stat st;
+	const bool have_stat = fstat(fd, &st) == 0;
 
-		return false;	
+	Matrix_t* read_mat = NULL;
+	status = create_matrix_status(&read_mat,name_buffer,rows,cols);
+	if (status == MATRIX_OK) {
+		/* straight into the matrix, there is nothing to track yet */
+		status = read_matrix_field(fd, read_mat->data, (size_t) rows * cols * sizeof(unsigned int));
+	}
+	if (status != MATRIX_OK) {
+		destroy_matrix(&read_mat);
+		close(fd);
+		return status;
 	}
 
-	if (!create_matrix(m,name_buffer,rows,cols)) {
-		return false;
+	/* a file left behind by an interrupted incremental write is still readable, but may mix old and new blocks */
+	unsigned char trailer = MATRIX_FILE_CLEAN;
+	if (read(fd,&trailer,sizeof(trailer)) == sizeof(trailer) && trailer == MATRIX_FILE_UPDATING) {
+		status = MATRIX_TORN_FILE;
+	}
+	else if (have_stat) {
+		track_matrix_file(read_mat, matrix_input_filename, &st);
 	}
 
-	load_matrix(*m,data);
-	free(data);
 	if (close(fd)) {
-		return false;
-
+		destroy_matrix(&read_mat);
+		return MATRIX_ERR_IO;
 	}
-	return true;
+	*m = read_mat;
+	return status;
+}
+
+	/*
+		PURPOSE: This function is read_matrix_status for callers that only need to know whether a matrix was read.
+		INPUTS: matrix_input_filename, m -> as for read_matrix_status.
+		RETURNS: true when a matrix was read, even from a file left behind by an interrupted incremental write; false otherwise.
+	*/
+
+bool read_matrix (const char* matrix_input_filename, Matrix_t** m) {
+
+	const Matrix_Status_t status = read_matrix_status(matrix_input_filename, m);
+	return status == MATRIX_OK || status == MATRIX_TORN_FILE;
 }
 
 	/*
 		PURPOSE: This function will open up a file and write out the matrix to it, in binary. 
 		INPUTS: The inputs of the function are: matrix_output_filename -> which is the filename of the file that will have the binary-written matrix saved in
 			m -> the matrix to have its contents read and written to the file specified
-		RETURNS: The function returns a bool, true on successful writing to the file, and false if something is wrong with parameters; or if something happens during the writing process. 
+			When m was last written to or read from the same file and the file still has the expected header and size, only the row blocks
+			changed since then are written back, see write_matrix_dirty_blocks.
+		RETURNS: MATRIX_OK on success, MATRIX_ERR_ARGS on invalid parameters, MATRIX_ERR_OPEN when the file could not be created,
+			MATRIX_ERR_IO when writing it failed and MATRIX_ERR_NO_MEMORY when memory ran out.
 	*/
 
-bool write_matrix (const char* matrix_output_filename, Matrix_t* m) {
+Matrix_Status_t write_matrix_status (const char* matrix_output_filename, Matrix_t* m) {
 
-	if(strlen(matrix_output_filename) == 0)
-		return false;
+	if(!matrix_output_filename || strlen(matrix_output_filename) == 0)
+		return MATRIX_ERR_ARGS;
 
 	if(!m)
-		return false; 
+		return MATRIX_ERR_ARGS; 
 
-	int fd = open (matrix_output_filename, O_CREAT | O_RDWR | O_TRUNC, 0644);
-	/* ERROR HANDLING USING errorno*/
-	if (fd < 0) {
-		printf("FAILED TO CREATE/OPEN FILE FOR WRITING\n");
-		if (errno == EACCES ) {
-			perror("DO NOT HAVE ACCESS TO FILE\n");
-		}
-		else if (errno == EADDRINUSE ){
-			perror("FILE ALREADY IN USE\n");
-		}
-		else if (errno == EBADF) {
-			perror("BAD FILE DESCRIPTOR\n");	
-		}
-		else if (errno == EEXIST) {
-			perror("FILE EXISTS\n");
-		}
-		return false;
+	/* only the changed row blocks need to go out when the file already holds this matrix */
+	if (write_matrix_dirty_blocks(matrix_output_filename, m)) {
+		return MATRIX_OK;
 	}
+
 	/* Calculate the needed buffer for our matrix */
 	unsigned int name_len = strlen(m->name) + 1;
-	unsigned int numberOfBytes = sizeof(unsigned int) + (sizeof(unsigned int)  * 2) + name_len + sizeof(unsigned int) * m->rows * m->cols + 1;
+	const size_t numberOfBytes = sizeof(unsigned int) + (sizeof(unsigned int)  * 2) + name_len + sizeof(unsigned int) * (size_t) m->rows * m->cols + 1;
 	/* Allocate the output_buffer in bytes
 	 * IMPORTANT TO UNDERSTAND THIS WAY OF MOVING MEMORY
 	 */
 	unsigned char* output_buffer = calloc(numberOfBytes,sizeof(unsigned char));
-	unsigned int offset = 0;
+	if (!output_buffer) {
+		return MATRIX_ERR_NO_MEMORY;
+	}
+	size_t offset = 0;
 	memcpy(&output_buffer[offset], &name_len, sizeof(unsigned int)); // IMPORTANT C FUNCTION TO KNOW
 	offset += sizeof(unsigned int);	
 	memcpy(&output_buffer[offset], m->name,name_len);
@@ -410,38 +491,57 @@ bool write_matrix (const char* matrix_output_filename, Matrix_t* m) {
 	offset += sizeof(unsigned int);
 	memcpy(&output_buffer[offset],&m->cols,sizeof(unsigned int));
 	offset += sizeof(unsigned int);
-	memcpy (&output_buffer[offset],m->data,m->rows * m->cols * sizeof(unsigned int));
-	offset += (m->rows * m->cols * sizeof(unsigned int));
-	output_buffer[numberOfBytes - 1] = EOF;
-
-	if (write(fd,output_buffer,numberOfBytes) != numberOfBytes) {
-		printf("FAILED TO WRITE MATRIX TO FILE\n");
-		if (errno == EACCES ) {
-			perror("DO NOT HAVE ACCESS TO FILE\n");
-		}
-		else if (errno == EADDRINUSE ){
-			perror("FILE ALREADY IN USE\n");
-		}
-		else if (errno == EBADF) {
-			perror("BAD FILE DESCRIPTOR\n");	
+	memcpy (&output_buffer[offset],m->data,(size_t) m->rows * m->cols * sizeof(unsigned int));
+	offset += ((size_t) m->rows * m->cols * sizeof(unsigned int));
+	output_buffer[numberOfBytes - 1] = MATRIX_FILE_CLEAN;
+
+	int fd = open (matrix_output_filename, O_CREAT | O_RDWR | O_TRUNC, 0644);
+	if (fd < 0) {
+		free(output_buffer);
+		return MATRIX_ERR_OPEN;
+	}
+
+	Matrix_Status_t status = MATRIX_OK;
+	size_t done = 0;
+	while (done < numberOfBytes) {
+		ssize_t n = write(fd, output_buffer + done, numberOfBytes - done);
+		if (n < 0 && errno == EINTR) {
+			continue;
 		}
-		else if (errno == EEXIST) {
-			perror("FILE EXIST\n");
+		if (n <= 0) {
+			status = MATRIX_ERR_IO;
+			break;
 		}
-		return false;
-	}
-	
-	if (close(fd)) {
-		return false;
+		done += n;
 	}
 	free(output_buffer);
 
-	return true;
+	/* identified after the last write, which set the modification time */
+	struct stat st;
+	const bool have_stat = status == MATRIX_OK && fstat(fd, &st) == 0;
+	if (close(fd) && status == MATRIX_OK) {
+		status = MATRIX_ERR_IO;
+	}
+	if (status == MATRIX_OK && have_stat) {
+		track_matrix_file(m, matrix_output_filename, &st);
+	}
+	return status;
+}
+
+	/*
+		PURPOSE: This function is write_matrix_status for callers that only need to know whether the matrix was written.
+		INPUTS: matrix_output_filename, m -> as for write_matrix_status.
+		RETURNS: true on success, false otherwise.
+	*/
+
+bool write_matrix (const char* matrix_output_filename, Matrix_t* m) {
+
+	return write_matrix_status(matrix_output_filename, m) == MATRIX_OK;
 }
 
 	/*
 		PURPOSE: The purpose of this function is to iterate over each of the fields in the matrix, and generate a random value for it. It also checks to make sure that the start and end range make sense
-			e.g. start range is less than end range, otherwise, the values are flipped and the function is re-called. 
+			e.g. start range is less than end range, otherwise, the values are flipped. 
 		INPUTS: The inputs are: m -> the matrix, which will be iterated over and have random values generated for
 			start_range -> the starting range for the random value generator
 			end_range -> the end range for the random value generator
@@ -450,71 +550,348 @@ bool write_matrix (const char* matrix_output_filename, Matrix_t* m) {
 
 bool random_matrix(Matrix_t* m, unsigned int start_range, unsigned int end_range) {
 	
+	return random_matrix_seeded(m, start_range, end_range, NULL);
+}
+
+	/*
+		PURPOSE: This function is random_matrix with the generator state held by the caller, so threads filling matrices at the same time
+			neither share nor disturb one sequence, and a seed gives the same matrix every time.
+		INPUTS: m, start_range, end_range -> as for random_matrix. seed -> the rand_r state, updated in place; NULL uses the process wide
+			rand sequence.
+		RETURNS: false on invalid parameters, true otherwise.
+	*/
+
+bool random_matrix_seeded (Matrix_t* m, unsigned int start_range, unsigned int end_range, unsigned int* seed) {
+
 	if(m == NULL){
-		printf("Error: passed in matrix is null; returning.\n");
 		return false; 
 	}
 
 	if(start_range > end_range){
-		printf("Error, ranges are out of place, flip-flopping them.\n");
-		int temp = start_range; 
+		unsigned int temp = start_range; 
 		start_range = end_range; 
 		end_range = temp; 
-		random_matrix(m, start_range, end_range);
 	}
 
-	for (unsigned int i = 0; i < m->rows; ++i) {
-		for (unsigned int j = 0; j < m->cols; ++j) {
-			m->data[i * m->cols + j] = rand() % (end_range + 1 - start_range) + start_range;
+	for (unsigned int r = 0; r < m->rows; ++r) {
+		unsigned int* x = &m->data[(size_t) r * m->cols];
+		unsigned int changed = 0;
+		UPDATE_CELLS(m->cols, (seed ? (unsigned int) rand_r(seed) : (unsigned int) rand()) % (end_range + 1 - start_range) + start_range)
+		if (changed) {
+			mark_matrix_dirty(m, r, r + 1);
 		}
 	}
 	return true;
 }
 
-/*Protected Functions in C*/
-	
 	/*
-		PURPOSE: This function will "load" a matrix into memory, meaning that it will take an initialized matrix, one that is set to all 0's and fill it with data, that is read in or generated at runtime. 
-		INPUTS: The input are m -> the matrix to be populated with data. data -> the data that will be used to populate the matrix.
-		RETURNS: This function is a void function, meaning that it returns nothing. It manipulates data, but doesn't return anything, the manipulation is done though pointers. 
+		PURPOSE: This function records that rows [first_row, end_row) of a matrix have changed, so the next write_matrix to its synced file
+			rewrites the row blocks covering them, and the prefix sum index is rebuilt from first_row down on its next use. Every function
+			that modifies matrix data calls this. Matrices that were never written or read have no blocks to track.
+		INPUTS: m -> the modified matrix. first_row, end_row -> the half open range of modified rows, clamped to the matrix.
+		RETURNS: Nothing.
 	*/
 
-void load_matrix (Matrix_t* m, unsigned int* data) {
+void mark_matrix_dirty (Matrix_t* m, unsigned int first_row, unsigned int end_row) {
 
 	if(!m)
-		return; 
+		return;
 
-	if(data == NULL)
-		return; 
+	if (end_row > m->rows) {
+		end_row = m->rows;
+	}
+	if (first_row >= end_row) {
+		return;
+	}
+	/* index row i sums data rows [0, i), so rows up to first_row are still right */
+	if (m->prefix_sums && first_row + 1 < m->prefix_valid_rows) {
+		m->prefix_valid_rows = first_row + 1;
+	}
+	if (!m->dirty_blocks) {
+		return;
+	}
+	const unsigned int first_block = first_row / m->dirty_block_rows;
+	const unsigned int last_block = (end_row - 1) / m->dirty_block_rows;
+	memset(&m->dirty_blocks[first_block], 1, last_block - first_block + 1);
+}
+
+	/*
+		PURPOSE: This function is mark_matrix_dirty for kernels that note which rows they changed, typically one flag per row set by
+			whichever worker computed that row. Each run of changed rows is marked in one call.
+		INPUTS: m -> the modified matrix. changed_rows -> m->rows flags, non-zero for every row that changed.
+		RETURNS: Nothing.
+	*/
+
+void mark_matrix_rows_dirty (Matrix_t* m, const unsigned char* changed_rows) {
+
+	if(!m || !changed_rows)
+		return;
 
-	memcpy(m->data,data,m->rows * m->cols * sizeof(unsigned int));
+	for (unsigned int i = 0; i < m->rows; ) {
+		if (!changed_rows[i]) {
+			++i;
+			continue;
+		}
+		unsigned int e = i;
+		while (e < m->rows && changed_rows[e]) {
+			++e;
+		}
+		mark_matrix_dirty(m, i, e);
+		i = e;
+	}
 }
 
 	/*
-		PURPOSE: This function will take a passed in matrix and append to the end of the array that is holding or keeping track of all the matrices created (but not deleted) during runtime of the program
-		INPUTS: The inputs are: mats -> the array container for the matrices created (but not deleted) during runtime of the program. new_matrix -> the matrix to be added to the array. num_mats -> total
-			number of allowed matrices to be appended onto the array
-		RETURNS: The function returns a -1 if anything goes wrong with the input parameters; otherwise, it returns the position that the matrix was appended to the array. (Overwrites are allowed).
+		PURPOSE: This function overwrites the data of a matrix with new cells, copying and marking only the rows that differ, so writing
+			back an unchanged result does not make its rows dirty.
+		INPUTS: m -> the matrix. cells -> m->rows * m->cols cells in row-major order, must not overlap m->data.
+		RETURNS: Nothing.
 	*/
 
-unsigned int add_matrix_to_array (Matrix_t** mats, Matrix_t* new_matrix, unsigned int num_mats) {
+void update_matrix_data (Matrix_t* m, const unsigned int* cells) {
 
-	if(!mats)
-		return - 1; 
+	if(!m || !m->data || !cells)
+		return;
 
-	if(!new_matrix)
-		return - 1; 
+	const size_t row_bytes = (size_t) m->cols * sizeof(unsigned int);
+	for (unsigned int i = 0; i < m->rows; ++i) {
+		unsigned int* row = &m->data[(size_t) i * m->cols];
+		const unsigned int* src = &cells[(size_t) i * m->cols];
+		if (memcmp(row, src, row_bytes) != 0) {
+			memcpy(row, src, row_bytes);
+			mark_matrix_dirty(m, i, i + 1);
+		}
+	}
+}
 
-	if(num_mats <= 0)
-		return -1; 
+	/*
+		PURPOSE: This function names a status returned by the matrix functions, for callers that report it to a person.
+		INPUTS: status -> the status.
+		RETURNS: a constant string describing the status.
+	*/
+
+const char* matrix_status_string (Matrix_Status_t status) {
+
+	switch (status) {
+		case MATRIX_OK: return "OK";
+		case MATRIX_TORN_FILE: return "FILE WAS INTERRUPTED DURING AN INCREMENTAL WRITE";
+		case MATRIX_ERR_ARGS: return "INVALID PARAMETERS";
+		case MATRIX_ERR_NO_MEMORY: return "OUT OF MEMORY";
+		case MATRIX_ERR_SHAPE: return "MATRIX DIMENSIONS DO NOT MATCH";
+		case MATRIX_ERR_NOT_FOUND: return "NO MATRIX WITH THAT NAME";
+		case MATRIX_ERR_OPEN: return "FAILED TO OPEN FILE";
+		case MATRIX_ERR_IO: return "FAILED TO READ OR WRITE FILE";
+		case MATRIX_ERR_FORMAT: return "NOT A MATRIX FILE";
+		case MATRIX_ERR_FULL: return "MORE MATRICES THAN THE CONTEXT HAS SLOTS";
+		case MATRIX_ERR_DUPLICATE: return "DUPLICATE MATRIX NAME";
+	}
+	return "UNKNOWN STATUS";
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function applies one operation between n cells and a constant in place, for scalar_op_matrix and the column
+			vector path of broadcast_op_matrix.
+		INPUTS: x -> the cells. n -> how many. op -> a valid operation. value -> the right hand operand.
+		RETURNS: true if any cell got a new value.
+	*/
+
+static bool scalar_op_cells (unsigned int* x, size_t n, Matrix_Op_t op, unsigned int value) {
+
+	unsigned int changed = 0;
+	switch (op) {
+		case MATRIX_OP_ADD: UPDATE_CELLS(n, x[i] + value) break;
+		case MATRIX_OP_SUB: UPDATE_CELLS(n, x[i] - value) break;
+		case MATRIX_OP_MUL: UPDATE_CELLS(n, x[i] * value) break;
+		case MATRIX_OP_AND: UPDATE_CELLS(n, x[i] & value) break;
+		case MATRIX_OP_OR: UPDATE_CELLS(n, x[i] | value) break;
+		case MATRIX_OP_XOR: UPDATE_CELLS(n, x[i] ^ value) break;
+		case MATRIX_OP_MIN: UPDATE_CELLS(n, x[i] < value ? x[i] : value) break;
+		case MATRIX_OP_MAX: UPDATE_CELLS(n, x[i] > value ? x[i] : value) break;
+	}
+	return changed != 0;
+}
+
+	/*
+		PURPOSE: This function applies one operation between n cells and n vector entries in place, for the row vector path of
+			broadcast_op_matrix.
+		INPUTS: x -> the cells. v -> the vector. n -> how many. op -> a valid operation.
+		RETURNS: true if any cell got a new value.
+	*/
+
+static bool vector_op_cells (unsigned int* x, const unsigned int* v, size_t n, Matrix_Op_t op) {
+
+	unsigned int changed = 0;
+	switch (op) {
+		case MATRIX_OP_ADD: UPDATE_CELLS(n, x[i] + v[i]) break;
+		case MATRIX_OP_SUB: UPDATE_CELLS(n, x[i] - v[i]) break;
+		case MATRIX_OP_MUL: UPDATE_CELLS(n, x[i] * v[i]) break;
+		case MATRIX_OP_AND: UPDATE_CELLS(n, x[i] & v[i]) break;
+		case MATRIX_OP_OR: UPDATE_CELLS(n, x[i] | v[i]) break;
+		case MATRIX_OP_XOR: UPDATE_CELLS(n, x[i] ^ v[i]) break;
+		case MATRIX_OP_MIN: UPDATE_CELLS(n, x[i] < v[i] ? x[i] : v[i]) break;
+		case MATRIX_OP_MAX: UPDATE_CELLS(n, x[i] > v[i] ? x[i] : v[i]) break;
+	}
+	return changed != 0;
+}
+
+	/*
+		PURPOSE: This function reads one field of a matrix file, carrying on where the kernel cut a read short.
+		INPUTS: fd -> the open file. buffer -> receives the field. len -> the size of the field in bytes.
+		RETURNS: MATRIX_OK when the whole field was read, MATRIX_ERR_IO when reading failed and MATRIX_ERR_FORMAT when the file ended first.
+	*/
+
+static Matrix_Status_t read_matrix_field (int fd, void* buffer, size_t len) {
+
+	size_t done = 0;
+	while (done < len) {
+		ssize_t n = read(fd, (unsigned char*) buffer + done, len - done);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0) {
+			return MATRIX_ERR_IO;
+		}
+		if (n == 0) {
+			return MATRIX_ERR_FORMAT;
+		}
+		done += n;
+	}
+	return MATRIX_OK;
+}
+
+	/*
+		PURPOSE: This function remembers that a matrix is now identical to a file and starts dirty tracking against it with every block clean.
+			The device, inode and modification time are kept so a file replaced or modified by someone else is not updated in place.
+		INPUTS: m -> the matrix. filename -> the file it was just written to or read from. st -> the file's status at that point.
+		RETURNS: true if tracking started, false if memory ran out, in which case the matrix is simply written in full next time.
+	*/
+
+static bool track_matrix_file (Matrix_t* m, const char* filename, const struct stat* st) {
+
+	free(m->synced_file);
+	free(m->dirty_blocks);
+	m->synced_file = NULL;
+	m->dirty_blocks = NULL;
+
+	const size_t row_bytes = (size_t) m->cols * sizeof(unsigned int);
+	m->dirty_block_rows = row_bytes >= MATRIX_DIRTY_BLOCK_BYTES ? 1 : MATRIX_DIRTY_BLOCK_BYTES / row_bytes;
+	const unsigned int num_blocks = (m->rows + m->dirty_block_rows - 1) / m->dirty_block_rows;
 
-	static long int current_position = 0;
-	const long int pos = current_position % num_mats;
-	if ( mats[pos] ) {
-		destroy_matrix(&mats[pos]);
-	} 
-	mats[pos] = new_matrix;
-	current_position++;
+	m->synced_file = strdup(filename);
+	m->dirty_blocks = calloc(num_blocks, sizeof(unsigned char));
+	if (!m->synced_file || !m->dirty_blocks) {
+		free(m->synced_file);
+		free(m->dirty_blocks);
+		m->synced_file = NULL;
+		m->dirty_blocks = NULL;
+		return false;
+	}
+	m->synced_dev = st->st_dev;
+	m->synced_ino = st->st_ino;
+	m->synced_mtime = st->st_mtim;
+	return true;
+}
+
+	/*
+		PURPOSE: This function brings an existing matrix file up to date by rewriting only the dirty row blocks in place with pwrite.
+			The trailing byte of the file is set to MATRIX_FILE_UPDATING and made durable with fdatasync before any block is touched, the
+			blocks are made durable with a second fdatasync, and only then does the trailer go back to MATRIX_FILE_CLEAN, with a final
+			fdatasync. The header and size never change, so a crash part way leaves a well formed file whose trailer tells read_matrix it
+			holds a mix of versions. The file must be the very one tracking started on, same device, inode and modification time.
+		INPUTS: matrix_output_filename -> the file to update. m -> the matrix to write.
+		RETURNS: true if the file is now up to date. false if the file is not the one m is tracked against, was changed since, does not match
+			the matrix shape, or an I/O error happened; the caller then falls back to a full write.
+	*/
+
+static bool write_matrix_dirty_blocks (const char* matrix_output_filename, Matrix_t* m) {
+
+	if (!m->synced_file || !m->dirty_blocks || strcmp(m->synced_file, matrix_output_filename) != 0) {
+		return false;
+	}
+
+	int fd = open(matrix_output_filename, O_RDWR);
+	if (fd < 0) {
+		return false;
+	}
+
+	/* the file must still hold this matrix: the same file, unmodified since, with the same size and header */
+	const unsigned int name_len = strlen(m->name) + 1;
+	const off_t header_bytes = sizeof(unsigned int) * 3 + name_len;
+	const off_t data_bytes = (off_t) m->rows * m->cols * sizeof(unsigned int);
+	const off_t trailer_offset = header_bytes + data_bytes;
+	unsigned char expected[sizeof(unsigned int) * 3 + MATRIX_NAME_LEN];
+	unsigned char found[sizeof(expected)];
+	memcpy(&expected[0], &name_len, sizeof(unsigned int));
+	memcpy(&expected[sizeof(unsigned int)], m->name, name_len);
+	memcpy(&expected[sizeof(unsigned int) + name_len], &m->rows, sizeof(unsigned int));
+	memcpy(&expected[sizeof(unsigned int) * 2 + name_len], &m->cols, sizeof(unsigned int));
+
+	struct stat st;
+	if (fstat(fd, &st) || st.st_dev != m->synced_dev || st.st_ino != m->synced_ino
+		|| st.st_mtim.tv_sec != m->synced_mtime.tv_sec || st.st_mtim.tv_nsec != m->synced_mtime.tv_nsec
+		|| st.st_size != trailer_offset + 1
+		|| pread(fd, found, header_bytes, 0) != header_bytes || memcmp(found, expected, header_bytes) != 0) {
+		close(fd);
+		return false;
+	}
 
-	return pos;
+	const unsigned int num_blocks = (m->rows + m->dirty_block_rows - 1) / m->dirty_block_rows;
+	if (!memchr(m->dirty_blocks, 1, num_blocks)) {
+		close(fd);
+		return true;
+	}
+
+	unsigned char trailer = MATRIX_FILE_UPDATING;
+	if (pwrite(fd, &trailer, sizeof(trailer), trailer_offset) != sizeof(trailer) || fdatasync(fd)) {
+		close(fd);
+		return false;
+	}
+
+	for (unsigned int b = 0; b < num_blocks; ) {
+		if (!m->dirty_blocks[b]) {
+			++b;
+			continue;
+		}
+		/* coalesce neighbouring dirty blocks into one write */
+		unsigned int e = b;
+		while (e < num_blocks && m->dirty_blocks[e]) {
+			++e;
+		}
+		const unsigned int first_row = b * m->dirty_block_rows;
+		const unsigned int end_row = e * m->dirty_block_rows < m->rows ? e * m->dirty_block_rows : m->rows;
+		const unsigned char* src = (const unsigned char*) &m->data[(size_t) first_row * m->cols];
+		const off_t offset = header_bytes + (off_t) first_row * m->cols * sizeof(unsigned int);
+		const size_t len = (size_t) (end_row - first_row) * m->cols * sizeof(unsigned int);
+
+		size_t done = 0;
+		while (done < len) {
+			ssize_t n = pwrite(fd, src + done, len - done, offset + done);
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) {
+				close(fd);
+				return false;
+			}
+			done += n;
+		}
+		b = e;
+	}
+
+	/* every block is on disk before the file may claim to be clean again */
+	if (fdatasync(fd)) {
+		close(fd);
+		return false;
+	}
+	trailer = MATRIX_FILE_CLEAN;
+	if (pwrite(fd, &trailer, sizeof(trailer), trailer_offset) != sizeof(trailer) || fdatasync(fd) || fstat(fd, &st)) {
+		close(fd);
+		return false;
+	}
+	memset(m->dirty_blocks, 0, num_blocks);
+	m->synced_mtime = st.st_mtim;
+	return close(fd) == 0;
 }
+	
@@ -1,27 +1,91 @@
 #ifndef _MATRIX_H_
 #define _MATRIX_H_
 
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+
 #define MATRIX_NAME_LEN 25
+/* dirty tracking granularity, a block is as many whole rows as fit in this many bytes */
+#define MATRIX_DIRTY_BLOCK_BYTES 65536
+/* last byte of a matrix file, rewritten while an incremental write is in progress */
+#define MATRIX_FILE_CLEAN 0xFF
+#define MATRIX_FILE_UPDATING 0x00
+
+typedef enum {
+	MATRIX_OP_ADD,
+	MATRIX_OP_SUB,
+	MATRIX_OP_MUL,
+	MATRIX_OP_AND,
+	MATRIX_OP_OR,
+	MATRIX_OP_XOR,
+	MATRIX_OP_MIN,
+	MATRIX_OP_MAX
+}Matrix_Op_t;
+
+/* what the status returning functions report, MATRIX_OK is zero so a status can be tested like an error code */
+typedef enum {
+	MATRIX_OK = 0,
+	MATRIX_TORN_FILE, /* read, but the file was left behind by an interrupted incremental write */
+	MATRIX_ERR_ARGS,
+	MATRIX_ERR_NO_MEMORY,
+	MATRIX_ERR_SHAPE,
+	MATRIX_ERR_NOT_FOUND,
+	MATRIX_ERR_OPEN,
+	MATRIX_ERR_IO,
+	MATRIX_ERR_FORMAT,
+	MATRIX_ERR_FULL, /* more matrices than the context has slots */
+	MATRIX_ERR_DUPLICATE /* two matrices with the same name */
+}Matrix_Status_t;
+
+typedef enum {
+	PLACEMENT_HEAP, /* plain calloc, wherever the allocator puts it */
+	PLACEMENT_FIRST_TOUCH, /* each row block zeroed by a worker pinned to the node that later processes it */
+	PLACEMENT_INTERLEAVE /* pages spread round robin over all NUMA nodes */
+}Placement_t;
 
 typedef struct {
 	char name[MATRIX_NAME_LEN];
 	unsigned int rows;
 	unsigned int cols;
 	unsigned int *data;
+	size_t mapped_bytes; /* non-zero when data is an mmap region rather than a heap block */
+	char* synced_file; /* file the data was last written to or read from, NULL if none */
+	unsigned char* dirty_blocks; /* one flag per row block changed since synced_file was in sync */
+	dev_t synced_dev; /* device, inode and modification time of synced_file when it was last in sync */
+	ino_t synced_ino;
+	struct timespec synced_mtime;
+	unsigned int dirty_block_rows;
+	Placement_t placement;
+	unsigned long long* prefix_sums; /* (rows + 1) x (cols + 1) integral image, NULL until a range sum needs it */
+	unsigned int prefix_valid_rows; /* leading rows of prefix_sums that still match the data */
+	pthread_mutex_t prefix_lock; /* held while prefix_sums is built or read, so readers of the matrix can share it */
 }Matrix_t;
 
 bool create_matrix (Matrix_t** new_matrix, const char* name, const unsigned int rows, const unsigned int cols);
+Matrix_Status_t create_matrix_status (Matrix_t** new_matrix, const char* name, const unsigned int rows, const unsigned int cols);
 void destroy_matrix (Matrix_t** m); 
 bool write_matrix (const char* matrix_output_filename, Matrix_t* m);
+Matrix_Status_t write_matrix_status (const char* matrix_output_filename, Matrix_t* m);
 bool read_matrix (const char* matrix_input_filename, Matrix_t** m);
-int sum_matrix (Matrix_t* m);
+Matrix_Status_t read_matrix_status (const char* matrix_input_filename, Matrix_t** m);
+const char* matrix_status_string (Matrix_Status_t status);
 bool add_matrices (Matrix_t* a, Matrix_t* b, Matrix_t* c); 
 bool bitwise_shift_matrix (Matrix_t* a, char direction, unsigned int shift);
+bool scalar_op_matrix (Matrix_t* a, Matrix_Op_t op, unsigned int value);
+bool broadcast_op_matrix (Matrix_t* a, Matrix_t* v, Matrix_Op_t op);
+bool matrix_op_from_name (const char* name, Matrix_Op_t* op);
+void mark_matrix_dirty (Matrix_t* m, unsigned int first_row, unsigned int end_row);
+void mark_matrix_rows_dirty (Matrix_t* m, const unsigned char* changed_rows);
+void update_matrix_data (Matrix_t* m, const unsigned int* cells);
 bool duplicate_matrix (Matrix_t* src, Matrix_t* dest);
 bool equal_matrices (Matrix_t* a, Matrix_t* b); 
 void display_matrix (Matrix_t* m); 
+void print_matrix (FILE* out, Matrix_t* m);
 bool random_matrix(Matrix_t* m, unsigned int start_range, unsigned int end_range);
-unsigned int add_matrix_to_array (Matrix_t** mats, Matrix_t* new_matrix, unsigned int num_mats);
+bool random_matrix_seeded (Matrix_t* m, unsigned int start_range, unsigned int end_range, unsigned int* seed);
 
 
 #endif
@@ -0,0 +1,202 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "parallel.h"
+#include "topology.h"
+
+typedef struct {
+	Row_Range_Fn_t fn;
+	void* arg;
+	unsigned int first_row;
+	unsigned int end_row;
+	unsigned int worker;
+	int node; /* node to pin to, -1 to leave the thread where it is */
+}Row_Range_Task_t;
+
+/*protected functions*/
+static void* run_row_range (void* task);
+static unsigned int gcd (unsigned int a, unsigned int b);
+
+	/*
+		PURPOSE: This function reports how many workers a parallel kernel may use, which is the number of online processors capped at
+			PARALLEL_MAX_WORKERS, but never fewer than the number of NUMA nodes so every node gets a worker.
+		INPUTS: None.
+		RETURNS: the worker count, always at least 1.
+	*/
+
+unsigned int parallel_worker_count (void) {
+
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus < (long) topology_node_count()) {
+		cpus = topology_node_count();
+	}
+	if (cpus < 1) {
+		return 1;
+	}
+	if (cpus > PARALLEL_MAX_WORKERS) {
+		return PARALLEL_MAX_WORKERS;
+	}
+	return (unsigned int) cpus;
+}
+
+	/*
+		PURPOSE: This function decides how the rows of a matrix are split between workers. The split only depends on the shape, so every
+			kernel gives a worker the same rows, which are the rows it zeroed, and therefore placed, when the matrix was allocated first-touch.
+			Boundaries are moved onto page boundaries when that costs little balance, so no page is shared by two workers.
+		INPUTS: rows, cols -> the shape of the matrix. bounds -> room for PARALLEL_MAX_WORKERS + 1 entries, worker w gets the rows
+			[bounds[w], bounds[w + 1]).
+		RETURNS: the number of workers, 0 when there are no rows.
+	*/
+
+unsigned int parallel_partition (unsigned int rows, unsigned int cols, unsigned int* bounds) {
+
+	if(!bounds || rows == 0)
+		return 0;
+
+	unsigned long long cells = (unsigned long long) rows * cols;
+	unsigned int workers = parallel_worker_count();
+	if (cells / PARALLEL_MIN_CELLS < workers) {
+		workers = (unsigned int) (cells / PARALLEL_MIN_CELLS);
+	}
+	if (workers > rows) {
+		workers = rows;
+	}
+	if (workers < 1) {
+		workers = 1;
+	}
+
+	/* the fewest rows that always span whole pages */
+	const long page_size = sysconf(_SC_PAGESIZE);
+	const unsigned int row_bytes = cols * sizeof(unsigned int);
+	unsigned int granule = 1;
+	if (page_size > 0 && row_bytes > 0) {
+		granule = (unsigned int) page_size / gcd((unsigned int) page_size, row_bytes);
+	}
+	if (granule > rows / workers / 8) {
+		/* aligning would unbalance the workers more than sharing one page per boundary costs */
+		granule = 1;
+	}
+
+	bounds[0] = 0;
+	for (unsigned int w = 1; w < workers; ++w) {
+		unsigned int bound = (unsigned int) ((unsigned long long) rows * w / workers);
+		bound = (bound + granule / 2) / granule * granule;
+		bounds[w] = bound < bounds[w - 1] ? bounds[w - 1] : bound;
+	}
+	bounds[workers] = rows;
+	return workers;
+}
+
+	/*
+		PURPOSE: This function splits the rows of a matrix into contiguous ranges with parallel_partition and calls fn once per range, each
+			range on its own thread. On a machine with more than one NUMA node each thread is pinned to the node its rows belong to.
+			The calling thread runs the first range itself, and small matrices are handled entirely on the calling thread.
+		INPUTS: rows, cols -> the shape of the matrix being processed, used to decide how many workers are worth starting.
+			fn -> called as fn(first_row, end_row, worker, arg) for the half open row range [first_row, end_row).
+			arg -> passed through to fn unchanged.
+		RETURNS: the number of workers that ran, worker indices passed to fn are below this value. 0 if fn is null or there are no rows.
+	*/
+
+unsigned int parallel_for_rows (unsigned int rows, unsigned int cols, Row_Range_Fn_t fn, void* arg) {
+
+	if(!fn || rows == 0)
+		return 0;
+
+	unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+	const unsigned int workers = parallel_partition(rows, cols, bounds);
+	return parallel_for_bounds(bounds, workers, fn, arg);
+}
+
+	/*
+		PURPOSE: This function is parallel_for_rows over a split already made by parallel_partition. Kernels that size per worker scratch
+			from the worker count, or that make several passes which must give every worker the same rows, partition once and pass the
+			same split to every pass; a second parallel_partition could see a different processor count.
+		INPUTS: bounds, workers -> the split, as filled in and returned by parallel_partition. fn, arg -> as for parallel_for_rows.
+		RETURNS: the number of workers that ran, which is workers, or 0 if fn or bounds is null.
+	*/
+
+unsigned int parallel_for_bounds (const unsigned int* bounds, unsigned int workers, Row_Range_Fn_t fn, void* arg) {
+
+	if(!fn || !bounds || workers == 0)
+		return 0;
+
+	if (workers > PARALLEL_MAX_WORKERS)
+		workers = PARALLEL_MAX_WORKERS;
+
+	const bool pin = topology_node_count() > 1 && workers > 1;
+
+	Row_Range_Task_t tasks[PARALLEL_MAX_WORKERS];
+	pthread_t threads[PARALLEL_MAX_WORKERS];
+	bool started[PARALLEL_MAX_WORKERS] = {false};
+
+	for (unsigned int w = 0; w < workers; ++w) {
+		tasks[w].fn = fn;
+		tasks[w].arg = arg;
+		tasks[w].worker = w;
+		tasks[w].first_row = bounds[w];
+		tasks[w].end_row = bounds[w + 1];
+		tasks[w].node = pin ? (int) topology_worker_node(w, workers) : -1;
+	}
+
+	for (unsigned int w = 1; w < workers; ++w) {
+		started[w] = pthread_create(&threads[w], NULL, run_row_range, &tasks[w]) == 0;
+	}
+
+	/* the calling thread borrows the affinity of worker 0 and gets its own back afterwards */
+	cpu_set_t saved;
+	const bool restore = pin && pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) == 0;
+	run_row_range(&tasks[0]);
+	for (unsigned int w = 1; w < workers; ++w) {
+		if (started[w]) {
+			pthread_join(threads[w], NULL);
+		}
+		else {
+			/* could not get a thread, do the range here instead */
+			run_row_range(&tasks[w]);
+		}
+	}
+	if (restore) {
+		pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+	}
+	return workers;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function is the thread entry point that runs one row range.
+		INPUTS: task -> the Row_Range_Task_t describing the range.
+		RETURNS: always NULL.
+	*/
+
+static void* run_row_range (void* task) {
+
+	Row_Range_Task_t* t = task;
+	if (t->node >= 0) {
+		topology_pin_to_node((unsigned int) t->node);
+	}
+	t->fn(t->first_row, t->end_row, t->worker, t->arg);
+	return NULL;
+}
+
+	/*
+		PURPOSE: This function computes the greatest common divisor of two numbers.
+		INPUTS: a, b -> the numbers.
+		RETURNS: their greatest common divisor.
+	*/
+
+static unsigned int gcd (unsigned int a, unsigned int b) {
+
+	while (b) {
+		unsigned int r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
@@ -0,0 +1,15 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#define PARALLEL_MAX_WORKERS 64
+/* below this many cells per worker the thread start up costs more than it saves */
+#define PARALLEL_MIN_CELLS 65536
+
+typedef void (*Row_Range_Fn_t) (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+
+unsigned int parallel_worker_count (void);
+unsigned int parallel_partition (unsigned int rows, unsigned int cols, unsigned int* bounds);
+unsigned int parallel_for_rows (unsigned int rows, unsigned int cols, Row_Range_Fn_t fn, void* arg);
+unsigned int parallel_for_bounds (const unsigned int* bounds, unsigned int workers, Row_Range_Fn_t fn, void* arg);
+
+#endif
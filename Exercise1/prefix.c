@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "prefix.h"
+#include "parallel.h"
+
+typedef struct {
+	Matrix_t* m;
+	unsigned int first_row; /* first data row whose index row is rebuilt, the index row above it is valid */
+	unsigned long long* offsets; /* cols + 1 per worker, what each block of rows is missing from the rows above it */
+}Prefix_Job_t;
+
+/*protected functions*/
+static bool update_prefix_sums (Matrix_t* m);
+static void scan_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+static void offset_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+
+	/*
+		PURPOSE: This function brings the prefix sum index of a matrix up to date, creating it on first use. Index cell (i,j) holds the sum of
+			the cells in rows [0, i) and columns [0, j), so it has one more row and column than the matrix. Only the index rows below the
+			first changed row are rebuilt, with a blocked scan: each worker scans its own rows as if they started the matrix, the totals
+			carried into each block are chained together, then each worker adds its carry to its rows. The index has its own lock, so
+			any number of threads that only read the matrix may call this at once; writers of the matrix must still be kept out.
+		INPUTS: m -> the matrix.
+		RETURNS: true on success, false on invalid parameters or when memory ran out.
+	*/
+
+bool build_prefix_sums (Matrix_t* m) {
+
+	if(!m || !m->data)
+		return false;
+
+	pthread_mutex_lock(&m->prefix_lock);
+	const bool built = update_prefix_sums(m);
+	pthread_mutex_unlock(&m->prefix_lock);
+	return built;
+}
+
+	/*
+		PURPOSE: This function sums a rectangle of a matrix from the four index cells at its corners, building or patching the index first
+			if the matrix changed since it was last used. Like build_prefix_sums it may run alongside other readers of the matrix.
+		INPUTS: m -> the matrix. r0, c0 -> the top left cell. r1, c1 -> the bottom right cell, both corners included.
+			sum -> receives the sum of the rectangle.
+		RETURNS: true on success, false on invalid parameters, a rectangle outside the matrix or when memory ran out.
+	*/
+
+bool range_sum_matrix (Matrix_t* m, unsigned int r0, unsigned int c0, unsigned int r1, unsigned int c1, unsigned long long* sum) {
+
+	if(!m || !m->data || !sum)
+		return false;
+
+	if (r0 > r1 || c0 > c1 || r1 >= m->rows || c1 >= m->cols)
+		return false;
+
+	pthread_mutex_lock(&m->prefix_lock);
+	if (!update_prefix_sums(m)) {
+		pthread_mutex_unlock(&m->prefix_lock);
+		return false;
+	}
+	const size_t width = (size_t) m->cols + 1;
+	const unsigned long long* p = m->prefix_sums;
+	*sum = p[(r1 + 1) * width + c1 + 1] - p[(size_t) r0 * width + c1 + 1] - p[(r1 + 1) * width + c0] + p[(size_t) r0 * width + c0];
+	pthread_mutex_unlock(&m->prefix_lock);
+	return true;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function is build_prefix_sums without the locking, for callers that already hold prefix_lock.
+		INPUTS: m -> the matrix, with data.
+		RETURNS: true on success, false when memory ran out.
+	*/
+
+static bool update_prefix_sums (Matrix_t* m) {
+
+	const size_t width = (size_t) m->cols + 1;
+	if (!m->prefix_sums) {
+		m->prefix_sums = malloc(((size_t) m->rows + 1) * width * sizeof(unsigned long long));
+		if (!m->prefix_sums) {
+			return false;
+		}
+		memset(m->prefix_sums, 0, width * sizeof(unsigned long long));
+		m->prefix_valid_rows = 1;
+	}
+	if (m->prefix_valid_rows > m->rows) {
+		return true;
+	}
+
+	/* both passes and the chaining between them must see the same blocks, so the rows are split once */
+	unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+	const unsigned int workers = parallel_partition(m->rows, m->cols, bounds);
+	/* one offset per worker plus the running carry */
+	unsigned long long* offsets = malloc(((size_t) workers + 1) * width * sizeof(unsigned long long));
+	if (!offsets) {
+		return false;
+	}
+	Prefix_Job_t job = {m, m->prefix_valid_rows - 1, offsets};
+	parallel_for_bounds(bounds, workers, scan_row_range, &job);
+
+	/* chain the blocks: the one holding first_row started from the valid index row above it and is final already, every later block is
+	   missing the final index row above it, which is the carry */
+	unsigned long long* carry = &offsets[(size_t) workers * width];
+	bool first_block = true;
+	for (unsigned int w = 0; w < workers; ++w) {
+		const unsigned int start = bounds[w] > job.first_row ? bounds[w] : job.first_row;
+		if (start >= bounds[w + 1]) {
+			continue;
+		}
+		const unsigned long long* block_last = &m->prefix_sums[(size_t) bounds[w + 1] * width];
+		if (first_block) {
+			memcpy(carry, block_last, width * sizeof(unsigned long long));
+			first_block = false;
+			continue;
+		}
+		unsigned long long* offset = &offsets[(size_t) w * width];
+		for (size_t j = 0; j < width; ++j) {
+			offset[j] = carry[j];
+			carry[j] += block_last[j];
+		}
+	}
+	parallel_for_bounds(bounds, workers, offset_row_range, &job);
+	free(offsets);
+
+	m->prefix_valid_rows = m->rows + 1;
+	return true;
+}
+
+	/*
+		PURPOSE: This function is the first pass of build_prefix_sums, it fills the index rows of one block of data rows with running row
+			sums added down the block. The block holding first_row starts from the valid index row above it, the others start from zero.
+		INPUTS: first_row, end_row -> the data rows of the block. worker -> unused. arg -> the Prefix_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void scan_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Prefix_Job_t* job = arg;
+	Matrix_t* m = job->m;
+	const size_t width = (size_t) m->cols + 1;
+	const unsigned int start = first_row > job->first_row ? first_row : job->first_row;
+
+	for (unsigned int r = start; r < end_row; ++r) {
+		const unsigned int* in = &m->data[(size_t) r * m->cols];
+		unsigned long long* out = &m->prefix_sums[((size_t) r + 1) * width];
+		const unsigned long long* above = &m->prefix_sums[(size_t) r * width];
+		unsigned long long running = 0;
+		out[0] = 0;
+		if (r == start && start != job->first_row) {
+			for (unsigned int j = 0; j < m->cols; ++j) {
+				running += in[j];
+				out[j + 1] = running;
+			}
+		}
+		else {
+			for (unsigned int j = 0; j < m->cols; ++j) {
+				running += in[j];
+				out[j + 1] = running + above[j + 1];
+			}
+		}
+	}
+}
+
+	/*
+		PURPOSE: This function is the second pass of build_prefix_sums, it adds the carry from the rows above to every index row of a block.
+			The block holding first_row is final after the first pass and is skipped.
+		INPUTS: first_row, end_row -> the data rows of the block. worker -> selects the offset. arg -> the Prefix_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void offset_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Prefix_Job_t* job = arg;
+	Matrix_t* m = job->m;
+	const size_t width = (size_t) m->cols + 1;
+	if (first_row <= job->first_row) {
+		return;
+	}
+
+	const unsigned long long* offset = &job->offsets[(size_t) worker * width];
+	for (unsigned int r = first_row; r < end_row; ++r) {
+		unsigned long long* out = &m->prefix_sums[((size_t) r + 1) * width];
+		for (size_t j = 0; j < width; ++j) {
+			out[j] += offset[j];
+		}
+	}
+}
@@ -0,0 +1,9 @@
+#ifndef _PREFIX_H_
+#define _PREFIX_H_
+
+#include "matrix.h"
+
+bool build_prefix_sums (Matrix_t* m);
+bool range_sum_matrix (Matrix_t* m, unsigned int r0, unsigned int c0, unsigned int r1, unsigned int c1, unsigned long long* sum);
+
+#endif
@@ -0,0 +1,767 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <pthread.h>
+
+#include "scheduler.h"
+
+#define SCHEDULER_NAME_LEN 32
+
+typedef struct Task {
+	Commands_t* cmd;
+	bool barrier;
+	bool done;
+	bool has_position; /* publishes its matrix at position in the context instead of the next slot in turn */
+	unsigned long long position;
+	unsigned int pending; /* unfinished tasks this one waits for */
+	struct Task** successors;
+	unsigned int num_successors;
+	unsigned int max_successors;
+	char* output;
+	size_t output_len;
+}Task_t;
+
+/* the last writer of a matrix name and everybody who read it since */
+typedef struct {
+	char name[SCHEDULER_NAME_LEN];
+	Task_t* writer;
+	Task_t** readers;
+	unsigned int num_readers;
+	unsigned int max_readers;
+}Name_Entry_t;
+
+/* a worker owns the bottom of its deque, thieves take from the top */
+typedef struct {
+	pthread_mutex_t lock;
+	Task_t** items;
+	unsigned int top;
+	unsigned int bottom;
+	unsigned int capacity;
+}Task_Deque_t;
+
+typedef struct {
+	Scheduler_t* s;
+	unsigned int index;
+}Worker_Arg_t;
+
+struct Scheduler {
+	Command_Runner_t runner;
+	Matrix_Context_t* ctx;
+
+	/* guards the dependency graph, the task list and the ready count */
+	pthread_mutex_t lock;
+	pthread_cond_t work_ready;
+	pthread_cond_t all_done;
+	/* commands run holding it shared, publishing a matrix into the array takes it exclusive */
+	pthread_rwlock_t mats_lock;
+
+	Task_t** tasks; /* in submission order, output is flushed in this order */
+	unsigned int num_tasks;
+	unsigned int max_tasks;
+	unsigned int next_flush;
+	unsigned int outstanding;
+	unsigned int ready; /* tasks sitting in the deques */
+	unsigned int next_deque;
+	Task_t* last_barrier;
+	/* the context position handed to the next command that adds a matrix, unknown after a barrier that may add any number */
+	unsigned long long next_position;
+	bool positions_known;
+
+	Name_Entry_t* names;
+	unsigned int num_names;
+	unsigned int max_names;
+
+	Task_Deque_t* deques;
+	Worker_Arg_t* args;
+	pthread_t* threads;
+	unsigned int num_workers;
+	bool stopping;
+};
+
+/*
+ * Which command arguments name matrices and how they are used: 'r' read, 'w' written (and read),
+ * '-' not a matrix. The write commands count as writers: they record the file in the matrix, and the
+ * file they write is named after it, so ordering them by name also orders everything touching that file.
+ * For the same reason the read commands write the name of their file, which is the name of the matrix
+ * in it for every file this program writes. Commands missing from this table run as barriers.
+ * adds marks the commands that may add a matrix to the context. Each is given the context position
+ * its matrix goes to when it is submitted, so the slots fill in script order whatever order the adds
+ * finish in. Past the first lap that position already holds a matrix, which the add evicts and
+ * which any later command may name, so such an add runs as a barrier. The bit matrix and batch
+ * tables never evict, their commands only need the ordering by name.
+ */
+typedef struct {
+	const char* command;
+	const char* access;
+	bool adds;
+}Command_Access_t;
+
+static const Command_Access_t command_access[] = {
+	{"display", "r"},
+	{"add", "rrw", true},
+	{"+=", "wr"},
+	{"scalar", "w"},
+	{"broadcast", "wr"},
+	{"duplicate", "rw", true},
+	{"equal", "rr"},
+	{"diff", "rr"},
+	{"diff-first", "rr"},
+	{"shift", "w"},
+	{"read", "w", true},
+	{"write", "w"},
+	{"create", "w", true},
+	{"random", "w"},
+	{"sum", "r"},
+	{"stats", "r"},
+	{"topk", "r"},
+	{"info", "r"},
+	{"pack", "rw"},
+	{"unpack", "rw", true},
+	{"bitop", "-rrw"},
+	{"bitnot", "w"},
+	{"popcount", "r"},
+	{"bitshift", "w"},
+	{"bitmul", "rrw"},
+	{"bitdisplay", "r"},
+	{"bitwrite", "w"},
+	{"bitread", "w"},
+	{"convolve", "rrw", true},
+	{"stencil", "r---w", true},
+	{"stencil-bench", "rr"},
+	{"sort", "w"},
+	{"sortrows", "w-"},
+	{"percentile", "r-"},
+	{"rangesum", "r----"}, /* the prefix sum index it builds or patches has a lock of its own */
+	{"batch-create", "w---"},
+	{"batch-random", "w--"},
+	{"batch-add", "rrw"},
+	{"batch-mul", "rrw"},
+	{"batch-shift", "w--"},
+	{"batch-sum", "r"},
+	{"batch-equal", "rr"},
+	{"batch-get", "r-w", true},
+	{"batch-set", "w-r"},
+	{"batch-write", "w"},
+	{"batch-read", "w"},
+};
+
+static __thread Scheduler_t* current_scheduler = NULL;
+static __thread unsigned int current_worker = 0;
+static __thread Task_t* current_task = NULL;
+
+/*protected functions*/
+static void* worker_main (void* arg);
+static void run_task (Scheduler_t* s, Task_t* t);
+static void complete_task (Scheduler_t* s, Task_t* t);
+static void push_ready (Scheduler_t* s, Task_t* t, unsigned int deque);
+static Task_t* take_ready (Scheduler_t* s, unsigned int worker);
+static bool reserve_deques (Scheduler_t* s, unsigned int num_tasks);
+static bool add_dependency (Task_t* t, Task_t* before);
+static Name_Entry_t* find_name (Scheduler_t* s, const char* name);
+static bool track_access (Scheduler_t* s, Task_t* t, const char* name, bool writes);
+static void flush_output (Scheduler_t* s);
+static void reset_graph (Scheduler_t* s);
+
+	/*
+		PURPOSE: This function starts a scheduler that runs parsed commands concurrently on a pool of worker threads. Each submitted command
+			waits only for the earlier commands that use the same matrix names in a conflicting way, so independent commands overlap, while
+			the output of every command is still printed in submission order.
+		INPUTS: s -> receives the new scheduler. num_workers -> how many worker threads to start. runner -> executes one command and prints
+			its output to the given stream. ctx -> the matrices the commands operate on.
+		RETURNS: true if the scheduler is running, false on invalid parameters or when the workers could not be started.
+	*/
+
+bool create_scheduler (Scheduler_t** s, unsigned int num_workers, Command_Runner_t runner, Matrix_Context_t* ctx) {
+
+	if(!s || !runner || !ctx || num_workers == 0)
+		return false;
+
+	Scheduler_t* sched = calloc(1, sizeof(Scheduler_t));
+	if (!sched) {
+		return false;
+	}
+	sched->runner = runner;
+	sched->ctx = ctx;
+	sched->num_workers = num_workers;
+	pthread_mutex_init(&sched->lock, NULL);
+	pthread_cond_init(&sched->work_ready, NULL);
+	pthread_cond_init(&sched->all_done, NULL);
+	pthread_rwlock_init(&sched->mats_lock, NULL);
+
+	sched->deques = calloc(num_workers, sizeof(Task_Deque_t));
+	sched->threads = calloc(num_workers, sizeof(pthread_t));
+	sched->args = calloc(num_workers, sizeof(Worker_Arg_t));
+	if (!sched->deques || !sched->threads || !sched->args) {
+		free(sched->deques);
+		free(sched->threads);
+		free(sched->args);
+		free(sched);
+		return false;
+	}
+	for (unsigned int w = 0; w < num_workers; ++w) {
+		pthread_mutex_init(&sched->deques[w].lock, NULL);
+	}
+
+	unsigned int started = 0;
+	for (; started < num_workers; ++started) {
+		sched->args[started].s = sched;
+		sched->args[started].index = started;
+		if (pthread_create(&sched->threads[started], NULL, worker_main, &sched->args[started])) {
+			break;
+		}
+	}
+	sched->num_workers = started;
+	if (started == 0) {
+		destroy_scheduler(&sched);
+		return false;
+	}
+
+	*s = sched;
+	return true;
+}
+
+	/*
+		PURPOSE: This function queues one parsed command. It works out which matrix names the command reads and writes, makes it wait for the
+			last earlier writer of every name it touches and, if it writes, for every earlier reader too. Commands the scheduler does not
+			know and the session commands that touch every matrix act as barriers that wait for and hold back everything around them, and
+			so does a command that adds a matrix once the context has been filled, as the matrix it evicts is not known yet.
+		INPUTS: s -> the scheduler. cmd -> the parsed command, the scheduler takes ownership and destroys it once it has run.
+		RETURNS: true if the command was queued, false on invalid parameters or when memory ran out (cmd is then still owned by the caller).
+	*/
+
+bool submit_command (Scheduler_t* s, Commands_t* cmd) {
+
+	if(!s || !cmd || cmd->num_cmds == 0)
+		return false;
+
+	Task_t* t = calloc(1, sizeof(Task_t));
+	if (!t) {
+		return false;
+	}
+	t->cmd = cmd;
+
+	const char* access = NULL;
+	bool adds = false;
+	for (unsigned int i = 0; i < sizeof(command_access) / sizeof(command_access[0]); ++i) {
+		if (strncmp(cmd->cmds[0], command_access[i].command, strlen(command_access[i].command) + 1) == 0) {
+			access = command_access[i].access;
+			adds = command_access[i].adds;
+			break;
+		}
+	}
+	t->barrier = access == NULL;
+
+	pthread_mutex_lock(&s->lock);
+	if (s->outstanding == 0) {
+		reset_graph(s);
+	}
+	if (adds && s->positions_known) {
+		t->has_position = true;
+		t->position = s->next_position++;
+		t->barrier = t->position >= s->ctx->num_mats;
+	}
+	else if (adds) {
+		t->barrier = true;
+	}
+	else if (t->barrier) {
+		s->positions_known = false;
+	}
+	if (s->num_tasks == s->max_tasks) {
+		unsigned int max_tasks = s->max_tasks ? s->max_tasks * 2 : 64;
+		Task_t** tasks = realloc(s->tasks, max_tasks * sizeof(Task_t*));
+		if (!tasks) {
+			pthread_mutex_unlock(&s->lock);
+			free(t);
+			return false;
+		}
+		s->tasks = tasks;
+		s->max_tasks = max_tasks;
+	}
+	if (!reserve_deques(s, s->outstanding + 1)) {
+		pthread_mutex_unlock(&s->lock);
+		free(t);
+		return false;
+	}
+
+	bool ok = true;
+	if (t->barrier) {
+		for (unsigned int i = s->next_flush; i < s->num_tasks && ok; ++i) {
+			ok = add_dependency(t, s->tasks[i]);
+		}
+		/* everything after the barrier only needs to wait for the barrier */
+		for (unsigned int i = 0; i < s->num_names; ++i) {
+			free(s->names[i].readers);
+		}
+		s->num_names = 0;
+		s->last_barrier = t;
+	}
+	else {
+		ok = add_dependency(t, s->last_barrier);
+		for (unsigned int i = 1; i < cmd->num_cmds && access[i - 1] != '\0' && ok; ++i) {
+			if (access[i - 1] != '-') {
+				ok = track_access(s, t, cmd->cmds[i], access[i - 1] == 'w');
+			}
+		}
+	}
+	if (!ok) {
+		/* fall back to running this command on its own */
+		t->barrier = true;
+		for (unsigned int i = s->next_flush; i < s->num_tasks; ++i) {
+			add_dependency(t, s->tasks[i]);
+		}
+		s->last_barrier = t;
+	}
+
+	s->tasks[s->num_tasks++] = t;
+	s->outstanding++;
+	unsigned int deque = s->next_deque++ % s->num_workers;
+	bool runnable = t->pending == 0;
+	pthread_mutex_unlock(&s->lock);
+
+	if (runnable) {
+		push_ready(s, t, deque);
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function is the barrier used by the sync command: it waits until every submitted command has run and its output has
+			been printed.
+		INPUTS: s -> the scheduler.
+		RETURNS: Nothing.
+	*/
+
+void sync_scheduler (Scheduler_t* s) {
+
+	if(!s)
+		return;
+
+	pthread_mutex_lock(&s->lock);
+	while (s->outstanding > 0) {
+		pthread_cond_wait(&s->all_done, &s->lock);
+	}
+	flush_output(s);
+	reset_graph(s);
+	pthread_mutex_unlock(&s->lock);
+}
+
+	/*
+		PURPOSE: This function waits for every submitted command, stops the workers and frees the scheduler.
+		INPUTS: s -> the scheduler, set to NULL afterwards.
+		RETURNS: Nothing.
+	*/
+
+void destroy_scheduler (Scheduler_t** s) {
+
+	if(!s || !(*s))
+		return;
+
+	Scheduler_t* sched = *s;
+	sync_scheduler(sched);
+
+	pthread_mutex_lock(&sched->lock);
+	sched->stopping = true;
+	pthread_cond_broadcast(&sched->work_ready);
+	pthread_mutex_unlock(&sched->lock);
+	for (unsigned int w = 0; w < sched->num_workers; ++w) {
+		pthread_join(sched->threads[w], NULL);
+	}
+
+	for (unsigned int w = 0; w < sched->num_workers; ++w) {
+		pthread_mutex_destroy(&sched->deques[w].lock);
+		free(sched->deques[w].items);
+	}
+	free(sched->deques);
+	free(sched->args);
+	free(sched->threads);
+	free(sched->tasks);
+	free(sched->names);
+	pthread_rwlock_destroy(&sched->mats_lock);
+	pthread_cond_destroy(&sched->all_done);
+	pthread_cond_destroy(&sched->work_ready);
+	pthread_mutex_destroy(&sched->lock);
+	free(sched);
+	*s = NULL;
+}
+
+	/*
+		PURPOSE: This function adds a matrix to the context like context_add_matrix, but when called from a scheduled command it first waits
+			until no other command is using the matrices, and puts the matrix at the position the command was given when it was submitted.
+			Adding a matrix may evict and destroy the one in its slot, which must not happen while another command still holds a pointer
+			to it. Commands must not touch matrices looked up before the call afterwards.
+		INPUTS: ctx -> the context. new_matrix -> the matrix to add.
+		RETURNS: the slot the matrix was added at, or -1 on invalid parameters.
+	*/
+
+unsigned int publish_matrix (Matrix_Context_t* ctx, Matrix_t* new_matrix) {
+
+	unsigned int pos = 0;
+	Matrix_Status_t status = MATRIX_OK;
+	Task_t* t = current_task;
+	scheduler_begin_exclusive();
+	if (t && t->has_position) {
+		status = context_add_matrix_at(ctx, new_matrix, t->position, &pos);
+		t->has_position = false;
+	}
+	else {
+		status = context_add_matrix(ctx, new_matrix, &pos);
+	}
+	scheduler_end_exclusive();
+	return status == MATRIX_OK ? pos : (unsigned int) -1;
+}
+
+	/*
+		PURPOSE: This function waits until no other scheduled command is running, for commands that change a shared table of matrices.
+			Every scheduled command runs holding the matrix lock shared, so this trades it for the exclusive one. Does nothing when not
+			called from a scheduled command. Must be paired with scheduler_end_exclusive.
+		INPUTS: None.
+		RETURNS: Nothing.
+	*/
+
+void scheduler_begin_exclusive (void) {
+
+	Scheduler_t* s = current_scheduler;
+	if (!s) {
+		return;
+	}
+	pthread_rwlock_unlock(&s->mats_lock);
+	pthread_rwlock_wrlock(&s->mats_lock);
+}
+
+	/*
+		PURPOSE: This function lets other scheduled commands run again after scheduler_begin_exclusive.
+		INPUTS: None.
+		RETURNS: Nothing.
+	*/
+
+void scheduler_end_exclusive (void) {
+
+	Scheduler_t* s = current_scheduler;
+	if (!s) {
+		return;
+	}
+	pthread_rwlock_unlock(&s->mats_lock);
+	pthread_rwlock_rdlock(&s->mats_lock);
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function is the body of a worker thread: take a ready task, from its own deque first and by stealing otherwise, run it
+			and repeat until the scheduler stops.
+		INPUTS: arg -> the Worker_Arg_t of this worker.
+		RETURNS: always NULL.
+	*/
+
+static void* worker_main (void* arg) {
+
+	Worker_Arg_t* w = arg;
+	Scheduler_t* s = w->s;
+	current_scheduler = s;
+	current_worker = w->index;
+
+	for (;;) {
+		pthread_mutex_lock(&s->lock);
+		while (s->ready == 0 && !s->stopping) {
+			pthread_cond_wait(&s->work_ready, &s->lock);
+		}
+		if (s->ready == 0) {
+			pthread_mutex_unlock(&s->lock);
+			break;
+		}
+		/* reserve one queued task, it is in some deque even if not in ours */
+		s->ready--;
+		pthread_mutex_unlock(&s->lock);
+
+		Task_t* t = take_ready(s, current_worker);
+		run_task(s, t);
+		complete_task(s, t);
+	}
+	return NULL;
+}
+
+	/*
+		PURPOSE: This function runs one command with its output captured in memory, so it can be printed in submission order.
+		INPUTS: s -> the scheduler. t -> the task to run.
+		RETURNS: Nothing.
+	*/
+
+static void run_task (Scheduler_t* s, Task_t* t) {
+
+	FILE* out = open_memstream(&t->output, &t->output_len);
+
+	current_task = t;
+	pthread_rwlock_rdlock(&s->mats_lock);
+	s->runner(t->cmd, s->ctx, out ? out : stdout);
+	pthread_rwlock_unlock(&s->mats_lock);
+	current_task = NULL;
+
+	if (out) {
+		fclose(out);
+	}
+	destroy_commands(&t->cmd);
+}
+
+	/*
+		PURPOSE: This function marks a task done, releases the tasks waiting on it onto the finishing worker's own deque, prints whatever
+			output is now next in submission order and wakes sync_scheduler once nothing is outstanding.
+		INPUTS: s -> the scheduler. t -> the finished task.
+		RETURNS: Nothing.
+	*/
+
+static void complete_task (Scheduler_t* s, Task_t* t) {
+
+	pthread_mutex_lock(&s->lock);
+	t->done = true;
+	s->outstanding--;
+	unsigned int num_released = 0;
+	for (unsigned int i = 0; i < t->num_successors; ++i) {
+		Task_t* next = t->successors[i];
+		if (--next->pending == 0) {
+			/* reuse the successor list to hold the released tasks */
+			t->successors[num_released++] = next;
+		}
+	}
+	flush_output(s);
+	if (s->outstanding == 0) {
+		pthread_cond_broadcast(&s->all_done);
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	for (unsigned int i = 0; i < num_released; ++i) {
+		push_ready(s, t->successors[i], current_worker);
+	}
+}
+
+	/*
+		PURPOSE: This function puts a task whose dependencies are all done at the bottom of a worker deque and wakes a worker. Every deque
+			can already hold every outstanding task (see reserve_deques), so this never allocates and cannot fail.
+		INPUTS: s -> the scheduler. t -> the ready task. deque -> the worker deque to use.
+		RETURNS: Nothing.
+	*/
+
+static void push_ready (Scheduler_t* s, Task_t* t, unsigned int deque) {
+
+	Task_Deque_t* d = &s->deques[deque % s->num_workers];
+	pthread_mutex_lock(&d->lock);
+	if (d->bottom == d->capacity) {
+		/* the deque holds fewer tasks than its capacity, they only need sliding down to the front */
+		unsigned int live = d->bottom - d->top;
+		memmove(d->items, &d->items[d->top], live * sizeof(Task_t*));
+		d->top = 0;
+		d->bottom = live;
+	}
+	d->items[d->bottom++] = t;
+	pthread_mutex_unlock(&d->lock);
+
+	pthread_mutex_lock(&s->lock);
+	s->ready++;
+	pthread_cond_signal(&s->work_ready);
+	pthread_mutex_unlock(&s->lock);
+}
+
+	/*
+		PURPOSE: This function takes a reserved task: the newest one from the worker's own deque, which is the most likely to find its
+			matrices in cache, or else the oldest one from another worker's deque.
+		INPUTS: s -> the scheduler. worker -> the index of the calling worker.
+		RETURNS: the task, the caller must have reserved one through the ready count so this always finds one.
+	*/
+
+static Task_t* take_ready (Scheduler_t* s, unsigned int worker) {
+
+	for (;;) {
+		Task_Deque_t* own = &s->deques[worker];
+		pthread_mutex_lock(&own->lock);
+		if (own->bottom > own->top) {
+			Task_t* t = own->items[--own->bottom];
+			pthread_mutex_unlock(&own->lock);
+			return t;
+		}
+		pthread_mutex_unlock(&own->lock);
+
+		for (unsigned int i = 1; i < s->num_workers; ++i) {
+			Task_Deque_t* victim = &s->deques[(worker + i) % s->num_workers];
+			pthread_mutex_lock(&victim->lock);
+			if (victim->bottom > victim->top) {
+				Task_t* t = victim->items[victim->top++];
+				pthread_mutex_unlock(&victim->lock);
+				return t;
+			}
+			pthread_mutex_unlock(&victim->lock);
+		}
+	}
+}
+
+	/*
+		PURPOSE: This function grows every worker deque so it can hold num_tasks tasks. A deque never holds more than the outstanding
+			tasks, so reserving for them when a task is submitted leaves push_ready nothing that can fail. Called with the scheduler lock held.
+		INPUTS: s -> the scheduler. num_tasks -> the number of outstanding tasks including the one being submitted.
+		RETURNS: true on success, false when memory ran out; deques grown before that keep their new capacity.
+	*/
+
+static bool reserve_deques (Scheduler_t* s, unsigned int num_tasks) {
+
+	for (unsigned int w = 0; w < s->num_workers; ++w) {
+		Task_Deque_t* d = &s->deques[w];
+		pthread_mutex_lock(&d->lock);
+		if (d->capacity < num_tasks) {
+			unsigned int capacity = d->capacity ? d->capacity : 16;
+			while (capacity < num_tasks) {
+				capacity *= 2;
+			}
+			Task_t** items = realloc(d->items, capacity * sizeof(Task_t*));
+			if (!items) {
+				pthread_mutex_unlock(&d->lock);
+				return false;
+			}
+			d->items = items;
+			d->capacity = capacity;
+		}
+		pthread_mutex_unlock(&d->lock);
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function makes a task wait for an earlier one, unless the earlier one has already finished. Called with the scheduler
+			lock held.
+		INPUTS: t -> the waiting task. before -> the task it must run after, may be NULL.
+		RETURNS: true on success, false when memory ran out.
+	*/
+
+static bool add_dependency (Task_t* t, Task_t* before) {
+
+	if (!before || before->done || before == t) {
+		return true;
+	}
+	if (before->num_successors == before->max_successors) {
+		unsigned int max_successors = before->max_successors ? before->max_successors * 2 : 4;
+		Task_t** successors = realloc(before->successors, max_successors * sizeof(Task_t*));
+		if (!successors) {
+			return false;
+		}
+		before->successors = successors;
+		before->max_successors = max_successors;
+	}
+	before->successors[before->num_successors++] = t;
+	t->pending++;
+	return true;
+}
+
+	/*
+		PURPOSE: This function looks up the dependency entry of a matrix name, adding an empty one if the name is new. Called with the
+			scheduler lock held.
+		INPUTS: s -> the scheduler. name -> the matrix name.
+		RETURNS: the entry, or NULL when memory ran out.
+	*/
+
+static Name_Entry_t* find_name (Scheduler_t* s, const char* name) {
+
+	for (unsigned int i = 0; i < s->num_names; ++i) {
+		if (strncmp(s->names[i].name, name, SCHEDULER_NAME_LEN) == 0) {
+			return &s->names[i];
+		}
+	}
+	if (s->num_names == s->max_names) {
+		unsigned int max_names = s->max_names ? s->max_names * 2 : 16;
+		Name_Entry_t* names = realloc(s->names, max_names * sizeof(Name_Entry_t));
+		if (!names) {
+			return NULL;
+		}
+		s->names = names;
+		s->max_names = max_names;
+	}
+	Name_Entry_t* entry = &s->names[s->num_names++];
+	memset(entry, 0, sizeof(Name_Entry_t));
+	strncpy(entry->name, name, SCHEDULER_NAME_LEN - 1);
+	return entry;
+}
+
+	/*
+		PURPOSE: This function records one matrix access of a task and adds the dependencies it implies: a read waits for the last writer,
+			a write waits for the last writer and every reader since. Called with the scheduler lock held.
+		INPUTS: s -> the scheduler. t -> the task. name -> the matrix name. writes -> true if the task modifies or creates the matrix.
+		RETURNS: true on success, false when memory ran out.
+	*/
+
+static bool track_access (Scheduler_t* s, Task_t* t, const char* name, bool writes) {
+
+	Name_Entry_t* entry = find_name(s, name);
+	if (!entry || !add_dependency(t, entry->writer)) {
+		return false;
+	}
+
+	if (writes) {
+		for (unsigned int i = 0; i < entry->num_readers; ++i) {
+			if (!add_dependency(t, entry->readers[i])) {
+				return false;
+			}
+		}
+		entry->num_readers = 0;
+		entry->writer = t;
+		return true;
+	}
+
+	if (entry->num_readers == entry->max_readers) {
+		unsigned int max_readers = entry->max_readers ? entry->max_readers * 2 : 4;
+		Task_t** readers = realloc(entry->readers, max_readers * sizeof(Task_t*));
+		if (!readers) {
+			return false;
+		}
+		entry->readers = readers;
+		entry->max_readers = max_readers;
+	}
+	entry->readers[entry->num_readers++] = t;
+	return true;
+}
+
+	/*
+		PURPOSE: This function prints the captured output of finished tasks in submission order, stopping at the first unfinished one.
+			Called with the scheduler lock held.
+		INPUTS: s -> the scheduler.
+		RETURNS: Nothing.
+	*/
+
+static void flush_output (Scheduler_t* s) {
+
+	while (s->next_flush < s->num_tasks && s->tasks[s->next_flush]->done) {
+		Task_t* t = s->tasks[s->next_flush++];
+		if (t->output) {
+			fwrite(t->output, 1, t->output_len, stdout);
+			free(t->output);
+			t->output = NULL;
+		}
+	}
+	fflush(stdout);
+}
+
+	/*
+		PURPOSE: This function forgets every finished task once nothing is outstanding, so long scripts do not grow the graph forever,
+			and picks up the context position the next add goes to. Called with the scheduler lock held.
+		INPUTS: s -> the scheduler.
+		RETURNS: Nothing.
+	*/
+
+static void reset_graph (Scheduler_t* s) {
+
+	flush_output(s);
+	for (unsigned int i = 0; i < s->num_tasks; ++i) {
+		free(s->tasks[i]->output);
+		free(s->tasks[i]->successors);
+		free(s->tasks[i]);
+	}
+	for (unsigned int i = 0; i < s->num_names; ++i) {
+		free(s->names[i].readers);
+	}
+	s->num_tasks = 0;
+	s->next_flush = 0;
+	s->num_names = 0;
+	s->last_barrier = NULL;
+
+	pthread_mutex_lock(&s->ctx->lock);
+	s->next_position = s->ctx->next_slot;
+	pthread_mutex_unlock(&s->ctx->lock);
+	s->positions_known = true;
+}
@@ -0,0 +1,22 @@
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include <stdio.h>
+
+#include "command.h"
+#include "matrix.h"
+#include "context.h"
+
+typedef void (*Command_Runner_t) (Commands_t* cmd, Matrix_Context_t* ctx, FILE* out);
+
+typedef struct Scheduler Scheduler_t;
+
+bool create_scheduler (Scheduler_t** s, unsigned int num_workers, Command_Runner_t runner, Matrix_Context_t* ctx);
+bool submit_command (Scheduler_t* s, Commands_t* cmd);
+void sync_scheduler (Scheduler_t* s);
+void destroy_scheduler (Scheduler_t** s);
+unsigned int publish_matrix (Matrix_Context_t* ctx, Matrix_t* new_matrix);
+void scheduler_begin_exclusive (void);
+void scheduler_end_exclusive (void);
+
+#endif
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "session.h"
+
+#define SESSION_IOV_BATCH 64
+
+/*protected functions*/
+static bool save_matrices (const char* session_filename, Matrix_t** mats, unsigned int num_mats);
+static unsigned long long align_offset (unsigned long long offset);
+static bool write_all_vectors (int fd, struct iovec* iov, int iov_count);
+static bool restore_matrix_data (int fd, Matrix_t* m, const Session_Entry_t* entry);
+
+static const unsigned char zero_padding[SESSION_ALIGN];
+
+	/*
+		PURPOSE: This function writes every live matrix in a context into one container file, see save_matrices. The context is locked while
+			it is saved, so other threads cannot add to it or take from it meanwhile.
+		INPUTS: session_filename -> the file the session is saved to. ctx -> the context.
+		RETURNS: true when the session file was completely written and renamed into place, false on bad parameters or any I/O failure.
+	*/
+
+bool save_session (const char* session_filename, Matrix_Context_t* ctx) {
+
+	if(!ctx)
+		return false;
+
+	pthread_mutex_lock(&ctx->lock);
+	bool saved = save_matrices(session_filename, ctx->mats, ctx->num_mats);
+	pthread_mutex_unlock(&ctx->lock);
+	return saved;
+}
+
+	/*
+		PURPOSE: This function restores every matrix held in a session file and adds it to a context. Only the header and index are
+			read up front; the data of each matrix is mapped privately from the file, so pages are faulted in on first touch and changes made
+			to a restored matrix never reach the session file. The index is checked before anything is mapped: a session that would not
+			fit in the context, or that names two matrices the same, is refused whole rather than evicting its own matrices. A restored
+			matrix replaces a matrix of the same name already in the context, so saving again never writes a name twice.
+		INPUTS: session_filename -> the session file to restore. ctx -> the context the restored matrices are added to.
+			restored -> NULL, or receives the number of matrices restored; entries with an impossible shape or offset are skipped.
+		RETURNS: MATRIX_OK on success, MATRIX_ERR_ARGS on invalid parameters, MATRIX_ERR_OPEN when the file could not be opened,
+			MATRIX_ERR_FORMAT when it is not a valid session file, MATRIX_ERR_FULL when it holds more matrices than the context has slots,
+			MATRIX_ERR_DUPLICATE when two of its matrices share a name and MATRIX_ERR_NO_MEMORY when memory ran out.
+	*/
+
+Matrix_Status_t load_session (const char* session_filename, Matrix_Context_t* ctx, unsigned int* restored) {
+
+	if(!session_filename || strlen(session_filename) == 0)
+		return MATRIX_ERR_ARGS;
+
+	if(!ctx)
+		return MATRIX_ERR_ARGS;
+
+	if (restored) {
+		*restored = 0;
+	}
+
+	int fd = open(session_filename, O_RDONLY);
+	if (fd < 0) {
+		return MATRIX_ERR_OPEN;
+	}
+
+	struct stat st;
+	Session_Header_t header;
+	if (fstat(fd, &st) || pread(fd, &header, sizeof(header), 0) != sizeof(header)
+		|| memcmp(header.magic, SESSION_MAGIC, SESSION_MAGIC_LEN) != 0 || header.version != SESSION_VERSION) {
+		close(fd);
+		return MATRIX_ERR_FORMAT;
+	}
+
+	/* restoring more than there are slots would have the later matrices evict the earlier ones */
+	if (header.num_entries > ctx->num_mats) {
+		close(fd);
+		return MATRIX_ERR_FULL;
+	}
+
+	size_t index_bytes = sizeof(Session_Entry_t) * header.num_entries;
+	if (sizeof(header) + index_bytes > (size_t) st.st_size) {
+		close(fd);
+		return MATRIX_ERR_FORMAT;
+	}
+
+	Session_Entry_t* entries = calloc(header.num_entries ? header.num_entries : 1, sizeof(Session_Entry_t));
+	if (!entries) {
+		close(fd);
+		return MATRIX_ERR_NO_MEMORY;
+	}
+	if (pread(fd, entries, index_bytes, sizeof(header)) != (ssize_t) index_bytes) {
+		free(entries);
+		close(fd);
+		return MATRIX_ERR_FORMAT;
+	}
+
+	/* the index is small, bounded by the number of slots, so every pair is compared */
+	for (unsigned int e = 0; e < header.num_entries; ++e) {
+		entries[e].name[sizeof(entries[e].name) - 1] = '\0';
+		for (unsigned int f = 0; f < e; ++f) {
+			if (strcmp(entries[e].name, entries[f].name) == 0) {
+				free(entries);
+				close(fd);
+				return MATRIX_ERR_DUPLICATE;
+			}
+		}
+	}
+
+	Matrix_Status_t status = MATRIX_OK;
+	for (unsigned int e = 0; e < header.num_entries; ++e) {
+		unsigned long long data_bytes = (unsigned long long) entries[e].rows * entries[e].cols * sizeof(unsigned int);
+		if (entries[e].rows == 0 || entries[e].cols == 0 || strlen(entries[e].name) + 1 > MATRIX_NAME_LEN
+			|| entries[e].offset + data_bytes > (unsigned long long) st.st_size) {
+			continue;
+		}
+
+		Matrix_t* m = calloc(1, sizeof(Matrix_t));
+		if (!m) {
+			status = MATRIX_ERR_NO_MEMORY;
+			break;
+		}
+		strncpy(m->name, entries[e].name, MATRIX_NAME_LEN);
+		m->rows = entries[e].rows;
+		m->cols = entries[e].cols;
+		pthread_mutex_init(&m->prefix_lock, NULL);
+		if (!restore_matrix_data(fd, m, &entries[e])) {
+			pthread_mutex_destroy(&m->prefix_lock);
+			free(m);
+			continue;
+		}
+
+		Matrix_t* replaced = NULL;
+		if (context_take_matrix(ctx, m->name, &replaced) == MATRIX_OK) {
+			destroy_matrix(&replaced);
+		}
+		if (context_add_matrix(ctx, m, NULL) != MATRIX_OK) {
+			destroy_matrix(&m);
+			continue;
+		}
+		if (restored) {
+			++*restored;
+		}
+	}
+
+	free(entries);
+	close(fd);
+	return status;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function writes every live matrix in the array into one container file. The file starts with a header and an index of
+			(name, rows, cols, offset) entries, followed by the raw data of each matrix on its own page aligned section. Everything is written
+			in one sequential pass with writev into a temporary file that is renamed over the target once complete, so an interrupted save
+			never leaves a half written session behind.
+		INPUTS: session_filename -> the file the session is saved to. mats -> the array of matrices. num_mats -> the size of that array.
+		RETURNS: true when the session file was completely written and renamed into place, false on bad parameters or any I/O failure.
+	*/
+
+static bool save_matrices (const char* session_filename, Matrix_t** mats, unsigned int num_mats) {
+
+	if(!session_filename || strlen(session_filename) == 0)
+		return false;
+
+	if(!mats || num_mats == 0)
+		return false;
+
+	unsigned int num_entries = 0;
+	for (unsigned int i = 0; i < num_mats; ++i) {
+		if (mats[i] && mats[i]->data) {
+			++num_entries;
+		}
+	}
+
+	size_t index_bytes = sizeof(Session_Header_t) + sizeof(Session_Entry_t) * num_entries;
+	unsigned char* index_buffer = calloc(index_bytes, sizeof(unsigned char));
+	if (!index_buffer) {
+		return false;
+	}
+
+	Session_Header_t* header = (Session_Header_t*) index_buffer;
+	Session_Entry_t* entries = (Session_Entry_t*) (index_buffer + sizeof(Session_Header_t));
+	memcpy(header->magic, SESSION_MAGIC, SESSION_MAGIC_LEN);
+	header->version = SESSION_VERSION;
+	header->num_entries = num_entries;
+
+	/* lay out the data sections behind the index */
+	unsigned long long offset = align_offset(index_bytes);
+	unsigned int e = 0;
+	for (unsigned int i = 0; i < num_mats; ++i) {
+		if (!mats[i] || !mats[i]->data) {
+			continue;
+		}
+		strncpy(entries[e].name, mats[i]->name, sizeof(entries[e].name) - 1);
+		entries[e].rows = mats[i]->rows;
+		entries[e].cols = mats[i]->cols;
+		entries[e].offset = offset;
+		offset = align_offset(offset + (unsigned long long) mats[i]->rows * mats[i]->cols * sizeof(unsigned int));
+		++e;
+	}
+
+	char tmp_filename[PATH_MAX];
+	if (snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", session_filename) >= (int) sizeof(tmp_filename)) {
+		free(index_buffer);
+		return false;
+	}
+
+	int fd = open(tmp_filename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+	if (fd < 0) {
+		free(index_buffer);
+		return false;
+	}
+
+	/* header + index, then (data, padding) pairs, flushed in batches of iovecs */
+	struct iovec iov[SESSION_IOV_BATCH];
+	int iov_count = 0;
+	bool ok = true;
+
+	iov[iov_count].iov_base = index_buffer;
+	iov[iov_count++].iov_len = index_bytes;
+	iov[iov_count].iov_base = (void*) zero_padding;
+	iov[iov_count++].iov_len = align_offset(index_bytes) - index_bytes;
+
+	/* walk the array in the same order the index was built in */
+	e = 0;
+	for (unsigned int i = 0; i < num_mats && ok; ++i) {
+		const Matrix_t* m = mats[i];
+		if (!m || !m->data) {
+			continue;
+		}
+		size_t data_bytes = (size_t) m->rows * m->cols * sizeof(unsigned int);
+		unsigned long long end = align_offset(entries[e].offset + data_bytes);
+
+		if (iov_count + 2 > SESSION_IOV_BATCH) {
+			ok = write_all_vectors(fd, iov, iov_count);
+			iov_count = 0;
+		}
+		iov[iov_count].iov_base = m->data;
+		iov[iov_count++].iov_len = data_bytes;
+		iov[iov_count].iov_base = (void*) zero_padding;
+		iov[iov_count++].iov_len = end - (entries[e].offset + data_bytes);
+		++e;
+	}
+	if (ok && iov_count > 0) {
+		ok = write_all_vectors(fd, iov, iov_count);
+	}
+	free(index_buffer);
+
+	if (!ok) {
+		close(fd);
+		unlink(tmp_filename);
+		return false;
+	}
+
+	if (fsync(fd) || close(fd)) {
+		unlink(tmp_filename);
+		return false;
+	}
+
+	if (rename(tmp_filename, session_filename)) {
+		unlink(tmp_filename);
+		return false;
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function rounds a file offset up to the next session section boundary.
+		INPUTS: offset -> the offset to round.
+		RETURNS: the smallest multiple of SESSION_ALIGN that is not below offset.
+	*/
+
+static unsigned long long align_offset (unsigned long long offset) {
+	return (offset + SESSION_ALIGN - 1) / SESSION_ALIGN * SESSION_ALIGN;
+}
+
+	/*
+		PURPOSE: This function keeps calling writev until every byte described by the vectors has been written, resuming after short writes.
+		INPUTS: fd -> the file to write to. iov -> the vectors to write, they are modified as bytes go out. iov_count -> the number of vectors.
+		RETURNS: true when everything was written, false on a write error.
+	*/
+
+static bool write_all_vectors (int fd, struct iovec* iov, int iov_count) {
+
+	while (iov_count > 0) {
+		ssize_t n = writev(fd, iov, iov_count);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		while (iov_count > 0 && (size_t) n >= iov->iov_len) {
+			n -= iov->iov_len;
+			++iov;
+			--iov_count;
+		}
+		if (iov_count > 0) {
+			iov->iov_base = (unsigned char*) iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function gives a restored matrix its data. The section is mapped copy-on-write straight from the session file when its
+			offset lines up with the page size, otherwise it falls back to reading the section into a heap buffer.
+		INPUTS: fd -> the open session file. m -> the matrix being restored, rows and cols already set. entry -> the index entry of the matrix.
+		RETURNS: true when m->data is usable, false otherwise.
+	*/
+
+static bool restore_matrix_data (int fd, Matrix_t* m, const Session_Entry_t* entry) {
+
+	size_t data_bytes = (size_t) m->rows * m->cols * sizeof(unsigned int);
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	if (page_size > 0 && entry->offset % page_size == 0) {
+		void* mapping = mmap(NULL, data_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, entry->offset);
+		if (mapping != MAP_FAILED) {
+			m->data = mapping;
+			m->mapped_bytes = data_bytes;
+			return true;
+		}
+	}
+
+	m->data = calloc((size_t) m->rows * m->cols, sizeof(unsigned int));
+	if (!m->data) {
+		return false;
+	}
+	if (pread(fd, m->data, data_bytes, entry->offset) != (ssize_t) data_bytes) {
+		free(m->data);
+		m->data = NULL;
+		return false;
+	}
+	return true;
+}
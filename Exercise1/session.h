@@ -0,0 +1,29 @@
+#ifndef _SESSION_H_
+#define _SESSION_H_
+
+#include "matrix.h"
+#include "context.h"
+
+#define SESSION_MAGIC "MATSESS1"
+#define SESSION_MAGIC_LEN 8
+#define SESSION_VERSION 1
+/* matrix data sections start on this boundary so they can be mapped directly */
+#define SESSION_ALIGN 4096
+
+typedef struct {
+	char magic[SESSION_MAGIC_LEN];
+	unsigned int version;
+	unsigned int num_entries;
+}Session_Header_t;
+
+typedef struct {
+	char name[32];
+	unsigned int rows;
+	unsigned int cols;
+	unsigned long long offset;
+}Session_Entry_t;
+
+bool save_session (const char* session_filename, Matrix_Context_t* ctx);
+Matrix_Status_t load_session (const char* session_filename, Matrix_Context_t* ctx, unsigned int* restored);
+
+#endif
@@ -0,0 +1,319 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "sort.h"
+#include "parallel.h"
+
+typedef struct {
+	const unsigned int* keys;
+	const unsigned int* values; /* moved along with the keys, NULL when there are none */
+	unsigned int* keys_out;
+	unsigned int* values_out;
+	unsigned int stride; /* keys per row, the work is split by rows */
+	unsigned int shift; /* the digit is (key >> shift) % RADIX_BUCKETS */
+	unsigned int mask; /* only keys with (key & mask) == prefix are counted */
+	unsigned int prefix;
+	size_t* counts; /* RADIX_BUCKETS per worker: the histogram, then the scatter positions */
+}Radix_Job_t;
+
+typedef struct {
+	Matrix_t* m;
+	const unsigned int* rows_in;
+	const unsigned int* order;
+	unsigned char* changed; /* one flag per row, set for the rows whose contents were replaced */
+}Permute_Job_t;
+
+/*protected functions*/
+static bool radix_sort (unsigned int* keys, unsigned int* values, unsigned int rows, unsigned int stride);
+static void histogram_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+static void scatter_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+static void permute_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+
+	/*
+		PURPOSE: This function sorts every cell of a matrix into ascending row-major order with a parallel LSD radix sort. A copy is
+			sorted and written back, so rows that already held their sorted cells are not marked dirty.
+		INPUTS: m -> the matrix, sorted in place.
+		RETURNS: true on success, false on invalid parameters or when memory ran out.
+	*/
+
+bool sort_matrix (Matrix_t* m) {
+
+	if(!m || !m->data)
+		return false;
+
+	unsigned int* sorted = malloc((size_t) m->rows * m->cols * sizeof(unsigned int));
+	if (!sorted) {
+		return false;
+	}
+	memcpy(sorted, m->data, (size_t) m->rows * m->cols * sizeof(unsigned int));
+	if (!radix_sort(sorted, NULL, m->rows, m->cols)) {
+		free(sorted);
+		return false;
+	}
+	update_matrix_data(m, sorted);
+	free(sorted);
+	return true;
+}
+
+	/*
+		PURPOSE: This function reorders the rows of a matrix so the values in one column ascend. Rows with equal keys keep their order.
+			The key column is radix sorted together with the row numbers, then the rows are moved to their new places.
+		INPUTS: m -> the matrix, sorted in place. col -> the key column.
+		RETURNS: true on success, false on invalid parameters or when memory ran out.
+	*/
+
+bool sort_matrix_rows (Matrix_t* m, unsigned int col) {
+
+	if(!m || !m->data || col >= m->cols)
+		return false;
+
+	unsigned int* keys = malloc((size_t) m->rows * sizeof(unsigned int));
+	unsigned int* order = malloc((size_t) m->rows * sizeof(unsigned int));
+	unsigned int* rows_in = malloc((size_t) m->rows * m->cols * sizeof(unsigned int));
+	unsigned char* changed = calloc(m->rows ? m->rows : 1, 1);
+	if (!keys || !order || !rows_in || !changed) {
+		free(keys);
+		free(order);
+		free(rows_in);
+		free(changed);
+		return false;
+	}
+	for (unsigned int i = 0; i < m->rows; ++i) {
+		keys[i] = m->data[(size_t) i * m->cols + col];
+		order[i] = i;
+	}
+	bool sorted = radix_sort(keys, order, m->rows, 1);
+	if (sorted) {
+		/* gather from a copy so each worker writes its own rows of the matrix */
+		memcpy(rows_in, m->data, (size_t) m->rows * m->cols * sizeof(unsigned int));
+		Permute_Job_t job = {m, rows_in, order, changed};
+		parallel_for_rows(m->rows, m->cols, permute_range, &job);
+		mark_matrix_rows_dirty(m, changed);
+	}
+	free(keys);
+	free(order);
+	free(rows_in);
+	free(changed);
+	return sorted;
+}
+
+	/*
+		PURPOSE: This function finds the p-th percentile of the cells of a matrix by the nearest rank method, the smallest cell that at least
+			p percent of the cells are less than or equal to, without sorting. It is a radix select: one histogram pass per 8 bits, from the
+			top, each counting only the cells that match the digits already chosen, so the cost is linear and the matrix is not changed.
+		INPUTS: m -> the matrix. p -> the percentile, between 0 and 100; 0 gives the minimum, 50 the (lower) median and 100 the maximum.
+			value -> receives the percentile.
+		RETURNS: true on success, false on invalid parameters or when memory ran out.
+	*/
+
+bool percentile_matrix (Matrix_t* m, double p, unsigned int* value) {
+
+	if(!m || !m->data || !value)
+		return false;
+
+	if (!(p >= 0 && p <= 100))
+		return false;
+
+	const unsigned long long n = (unsigned long long) m->rows * m->cols;
+	const long double exact_rank = (long double) p / 100 * n;
+	unsigned long long rank = (unsigned long long) exact_rank;
+	rank += rank < exact_rank;
+	rank = rank < 1 ? 0 : rank - 1;
+	rank = rank >= n ? n - 1 : rank;
+
+	unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+	const unsigned int workers = parallel_partition(m->rows, m->cols, bounds);
+	size_t* counts = malloc((size_t) workers * RADIX_BUCKETS * sizeof(size_t));
+	if (!counts) {
+		return false;
+	}
+
+	Radix_Job_t job = {0};
+	job.keys = m->data;
+	job.stride = m->cols;
+	job.counts = counts;
+	for (int shift = 32 - RADIX_BITS; shift >= 0; shift -= RADIX_BITS) {
+		job.shift = shift;
+		parallel_for_bounds(bounds, workers, histogram_range, &job);
+		unsigned int digit = 0;
+		for (; digit < RADIX_BUCKETS; ++digit) {
+			unsigned long long in_bucket = 0;
+			for (unsigned int w = 0; w < workers; ++w) {
+				in_bucket += counts[(size_t) w * RADIX_BUCKETS + digit];
+			}
+			if (rank < in_bucket) {
+				break;
+			}
+			rank -= in_bucket;
+		}
+		job.prefix |= digit << shift;
+		job.mask |= (RADIX_BUCKETS - 1u) << shift;
+	}
+	free(counts);
+	*value = job.prefix;
+	return true;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function is a stable LSD radix sort of an array, one pass per 8 bits. Each pass has every worker histogram its own block
+			of rows, turns the histograms into the position each worker's first key of each digit goes to, and has every worker scatter its
+			block there. Passes whose digit is the same for every key are skipped. The rows are split once and every pass uses that split, so
+			a worker scatters exactly the keys it counted.
+		INPUTS: keys -> rows * stride keys, sorted in place. values -> NULL, or as many values moved with the keys. rows, stride -> the
+			array is split between workers by rows of stride keys.
+		RETURNS: true on success, false when memory ran out.
+	*/
+
+static bool radix_sort (unsigned int* keys, unsigned int* values, unsigned int rows, unsigned int stride) {
+
+	const size_t n = (size_t) rows * stride;
+	if (n == 0) {
+		return true;
+	}
+
+	unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+	const unsigned int workers = parallel_partition(rows, stride, bounds);
+	size_t* counts = malloc((size_t) workers * RADIX_BUCKETS * sizeof(size_t));
+	unsigned int* keys_tmp = malloc(n * sizeof(unsigned int));
+	unsigned int* values_tmp = values ? malloc(n * sizeof(unsigned int)) : NULL;
+	if (!counts || !keys_tmp || (values && !values_tmp)) {
+		free(counts);
+		free(keys_tmp);
+		free(values_tmp);
+		return false;
+	}
+
+	Radix_Job_t job = {0};
+	job.keys = keys;
+	job.values = values;
+	job.keys_out = keys_tmp;
+	job.values_out = values_tmp;
+	job.stride = stride;
+	job.counts = counts;
+	for (unsigned int shift = 0; shift < 32; shift += RADIX_BITS) {
+		job.shift = shift;
+		parallel_for_bounds(bounds, workers, histogram_range, &job);
+
+		/* exclusive prefix sum, digit major then worker, which keeps the sort stable */
+		size_t base = 0;
+		bool one_digit = false;
+		for (unsigned int d = 0; d < RADIX_BUCKETS; ++d) {
+			const size_t digit_start = base;
+			for (unsigned int w = 0; w < workers; ++w) {
+				const size_t count = counts[(size_t) w * RADIX_BUCKETS + d];
+				counts[(size_t) w * RADIX_BUCKETS + d] = base;
+				base += count;
+			}
+			one_digit = one_digit || base - digit_start == n;
+		}
+		if (one_digit) {
+			continue;
+		}
+
+		parallel_for_bounds(bounds, workers, scatter_range, &job);
+		const unsigned int* keys_in = job.keys;
+		const unsigned int* values_in = job.values;
+		job.keys = job.keys_out;
+		job.values = job.values_out;
+		job.keys_out = (unsigned int*) keys_in;
+		job.values_out = (unsigned int*) values_in;
+	}
+
+	if (job.keys != keys) {
+		memcpy(keys, job.keys, n * sizeof(unsigned int));
+		if (values) {
+			memcpy(values, job.values, n * sizeof(unsigned int));
+		}
+	}
+	free(counts);
+	free(keys_tmp);
+	free(values_tmp);
+	return true;
+}
+
+	/*
+		PURPOSE: This function counts the digits of one worker's block of keys. Four sub-histograms are filled in turn so consecutive keys
+			with the same digit do not wait on each other's increment, and the mask test is folded into the increment so there is no branch.
+		INPUTS: first_row, end_row -> the rows of keys to count. worker -> which histogram to fill. arg -> the Radix_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void histogram_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Radix_Job_t* job = arg;
+	const unsigned int* k = job->keys + (size_t) first_row * job->stride;
+	const size_t n = (size_t) (end_row - first_row) * job->stride;
+	const unsigned int shift = job->shift;
+	const unsigned int mask = job->mask;
+	const unsigned int prefix = job->prefix;
+
+	size_t sub[4][RADIX_BUCKETS];
+	memset(sub, 0, sizeof(sub));
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		sub[0][(k[i] >> shift) % RADIX_BUCKETS] += (k[i] & mask) == prefix;
+		sub[1][(k[i + 1] >> shift) % RADIX_BUCKETS] += (k[i + 1] & mask) == prefix;
+		sub[2][(k[i + 2] >> shift) % RADIX_BUCKETS] += (k[i + 2] & mask) == prefix;
+		sub[3][(k[i + 3] >> shift) % RADIX_BUCKETS] += (k[i + 3] & mask) == prefix;
+	}
+	for (; i < n; ++i) {
+		sub[0][(k[i] >> shift) % RADIX_BUCKETS] += (k[i] & mask) == prefix;
+	}
+
+	size_t* counts = &job->counts[(size_t) worker * RADIX_BUCKETS];
+	for (unsigned int d = 0; d < RADIX_BUCKETS; ++d) {
+		counts[d] = sub[0][d] + sub[1][d] + sub[2][d] + sub[3][d];
+	}
+}
+
+	/*
+		PURPOSE: This function moves one worker's block of keys, and their values, to the positions worked out from the histograms.
+		INPUTS: first_row, end_row -> the rows of keys to move. worker -> which positions to use. arg -> the Radix_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void scatter_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Radix_Job_t* job = arg;
+	const size_t first = (size_t) first_row * job->stride;
+	const size_t end = (size_t) end_row * job->stride;
+	const unsigned int shift = job->shift;
+	size_t* positions = &job->counts[(size_t) worker * RADIX_BUCKETS];
+
+	if (job->values) {
+		for (size_t i = first; i < end; ++i) {
+			const size_t pos = positions[(job->keys[i] >> shift) % RADIX_BUCKETS]++;
+			job->keys_out[pos] = job->keys[i];
+			job->values_out[pos] = job->values[i];
+		}
+	}
+	else {
+		for (size_t i = first; i < end; ++i) {
+			job->keys_out[positions[(job->keys[i] >> shift) % RADIX_BUCKETS]++] = job->keys[i];
+		}
+	}
+}
+
+	/*
+		PURPOSE: This function copies rows into their sorted places for sort_matrix_rows, flagging the rows whose contents change.
+		INPUTS: first_row, end_row -> the destination rows. worker -> unused. arg -> the Permute_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void permute_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Permute_Job_t* job = arg;
+	const size_t row_bytes = (size_t) job->m->cols * sizeof(unsigned int);
+	for (unsigned int i = first_row; i < end_row; ++i) {
+		unsigned int* row = &job->m->data[(size_t) i * job->m->cols];
+		const unsigned int* src = &job->rows_in[(size_t) job->order[i] * job->m->cols];
+		if (job->order[i] != i && memcmp(row, src, row_bytes) != 0) {
+			memcpy(row, src, row_bytes);
+			job->changed[i] = 1;
+		}
+	}
+}
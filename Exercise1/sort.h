@@ -0,0 +1,14 @@
+#ifndef _SORT_H_
+#define _SORT_H_
+
+#include "matrix.h"
+
+/* the radix sort handles 8 bits of a cell per pass */
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+bool sort_matrix (Matrix_t* m);
+bool sort_matrix_rows (Matrix_t* m, unsigned int col);
+bool percentile_matrix (Matrix_t* m, double p, unsigned int* value);
+
+#endif
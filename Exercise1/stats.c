@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include "stats.h"
+#include "parallel.h"
+
+/* per worker partial results, padded so workers never share a cache line */
+typedef struct {
+	unsigned int min;
+	unsigned int max;
+	unsigned long long sum;
+	unsigned long long nonzero;
+	unsigned __int128 sum_squares;
+	unsigned long long* counts;
+	char pad[64];
+}Stats_Partial_t;
+
+typedef struct {
+	const Matrix_t* m;
+	Matrix_Stats_t* stats;
+	Stats_Partial_t* partials;
+}Stats_Job_t;
+
+typedef struct {
+	const Matrix_t* m;
+	unsigned int k;
+	Matrix_Cell_t* heaps;
+	unsigned int* sizes;
+}Topk_Job_t;
+
+/*protected functions*/
+static void stats_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+static void topk_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+static void heap_offer (Matrix_Cell_t* heap, unsigned int* size, unsigned int k, Matrix_Cell_t cell);
+static void heap_sift_down (Matrix_Cell_t* heap, unsigned int size, unsigned int i);
+
+	/*
+		PURPOSE: This function summarizes a matrix in one pass over its data: min, max, sum, mean, population variance, the count of non zero
+			cells and, when stats->num_bins is set, a histogram of stats->num_bins equal width bins over [stats->hist_low, stats->hist_high].
+			Cells outside that range are left out of the histogram. Rows are split across workers that each keep their own partial results,
+			which are merged at the end.
+		INPUTS: m -> the matrix to summarize. stats -> receives the results; num_bins, hist_low and hist_high are read as the histogram request.
+		RETURNS: true on success, in which case stats->counts must be released with destroy_stats. false on invalid parameters or when
+			memory for the histogram could not be allocated.
+	*/
+
+bool stats_matrix (Matrix_t* m, Matrix_Stats_t* stats) {
+
+	if(!m || !m->data || !stats)
+		return false;
+
+	if (stats->num_bins > 0 && stats->hist_low > stats->hist_high)
+		return false;
+
+	unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+	const unsigned int workers = parallel_partition(m->rows, m->cols, bounds);
+	Stats_Partial_t* partials = calloc(workers, sizeof(Stats_Partial_t));
+	if (!partials) {
+		return false;
+	}
+	stats->counts = NULL;
+	if (stats->num_bins > 0) {
+		stats->counts = calloc(stats->num_bins, sizeof(unsigned long long));
+		for (unsigned int w = 0; w < workers && stats->counts; ++w) {
+			partials[w].counts = calloc(stats->num_bins, sizeof(unsigned long long));
+			if (!partials[w].counts) {
+				free(stats->counts);
+				stats->counts = NULL;
+			}
+		}
+		if (!stats->counts) {
+			for (unsigned int w = 0; w < workers; ++w) {
+				free(partials[w].counts);
+			}
+			free(partials);
+			return false;
+		}
+	}
+
+	Stats_Job_t job = {m, stats, partials};
+	parallel_for_bounds(bounds, workers, stats_row_range, &job);
+
+	stats->min = UINT_MAX;
+	stats->max = 0;
+	stats->sum = 0;
+	stats->nonzero = 0;
+	unsigned __int128 sum_squares = 0;
+	for (unsigned int w = 0; w < workers; ++w) {
+		stats->min = partials[w].min < stats->min ? partials[w].min : stats->min;
+		stats->max = partials[w].max > stats->max ? partials[w].max : stats->max;
+		stats->sum += partials[w].sum;
+		stats->nonzero += partials[w].nonzero;
+		sum_squares += partials[w].sum_squares;
+		for (unsigned int b = 0; b < stats->num_bins; ++b) {
+			stats->counts[b] += partials[w].counts[b];
+		}
+	}
+	for (unsigned int w = 0; w < workers; ++w) {
+		free(partials[w].counts);
+	}
+	free(partials);
+
+	const long double n = (long double) m->rows * m->cols;
+	const long double mean = stats->sum / n;
+	stats->mean = (double) mean;
+	stats->variance = (double) ((long double) sum_squares / n - mean * mean);
+	if (stats->variance < 0) {
+		stats->variance = 0;
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function releases the histogram allocated by stats_matrix.
+		INPUTS: stats -> the statistics filled in by stats_matrix.
+		RETURNS: Nothing.
+	*/
+
+void destroy_stats (Matrix_Stats_t* stats) {
+
+	if(!stats)
+		return;
+
+	free(stats->counts);
+	stats->counts = NULL;
+}
+
+	/*
+		PURPOSE: This function finds the k largest cells of a matrix with a bounded min-heap per worker, then merges the worker heaps.
+		INPUTS: m -> the matrix to search. k -> how many cells to report. cells -> room for k cells, filled largest value first.
+		RETURNS: the number of cells written to cells, which is k unless the matrix has fewer cells, or 0 on invalid parameters.
+	*/
+
+unsigned int topk_matrix (Matrix_t* m, unsigned int k, Matrix_Cell_t* cells) {
+
+	if(!m || !m->data || !cells || k == 0)
+		return 0;
+
+	if ((unsigned long long) k > (unsigned long long) m->rows * m->cols) {
+		k = m->rows * m->cols;
+	}
+
+	unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+	const unsigned int workers = parallel_partition(m->rows, m->cols, bounds);
+	Matrix_Cell_t* heaps = calloc((size_t) workers * k, sizeof(Matrix_Cell_t));
+	unsigned int* sizes = calloc(workers, sizeof(unsigned int));
+	if (!heaps || !sizes) {
+		free(heaps);
+		free(sizes);
+		return 0;
+	}
+
+	Topk_Job_t job = {m, k, heaps, sizes};
+	parallel_for_bounds(bounds, workers, topk_row_range, &job);
+
+	/* merge every worker heap into the output, which doubles as the final heap */
+	unsigned int size = 0;
+	for (unsigned int w = 0; w < workers; ++w) {
+		for (unsigned int i = 0; i < sizes[w]; ++i) {
+			heap_offer(cells, &size, k, heaps[(size_t) w * k + i]);
+		}
+	}
+	free(heaps);
+	free(sizes);
+
+	/* heap sort in place, popping the minimum to the back leaves the largest first */
+	for (unsigned int end = size; end > 1; --end) {
+		Matrix_Cell_t smallest = cells[0];
+		cells[0] = cells[end - 1];
+		cells[end - 1] = smallest;
+		heap_sift_down(cells, end - 1, 0);
+	}
+	return size;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function is the per worker body of stats_matrix. The statistics loop is branch free so it vectorizes, and the histogram
+			is filled from the same row while it is still in cache.
+		INPUTS: first_row, end_row -> the rows to process. worker -> the index of the partial to fill. arg -> the Stats_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void stats_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Stats_Job_t* job = arg;
+	const Matrix_t* m = job->m;
+	Stats_Partial_t* p = &job->partials[worker];
+	const unsigned int num_bins = job->stats->num_bins;
+	const unsigned int low = job->stats->hist_low;
+	const unsigned long long range = (unsigned long long) job->stats->hist_high - low + 1;
+
+	unsigned int mn = UINT_MAX;
+	unsigned int mx = 0;
+	unsigned long long sum = 0;
+	unsigned long long nonzero = 0;
+	unsigned __int128 sum_squares = 0;
+
+	for (unsigned int i = first_row; i < end_row; ++i) {
+		const unsigned int* row = &m->data[(size_t) i * m->cols];
+		unsigned long long row_sum = 0;
+		unsigned long long row_nonzero = 0;
+		for (unsigned int j = 0; j < m->cols; ++j) {
+			const unsigned int v = row[j];
+			mn = v < mn ? v : mn;
+			mx = v > mx ? v : mx;
+			row_sum += v;
+			row_nonzero += v != 0;
+		}
+		for (unsigned int j = 0; j < m->cols; ++j) {
+			sum_squares += (unsigned long long) row[j] * row[j];
+		}
+		if (num_bins > 0) {
+			for (unsigned int j = 0; j < m->cols; ++j) {
+				const unsigned long long offset = (unsigned long long) row[j] - low;
+				if (row[j] >= low && offset < range) {
+					p->counts[offset * num_bins / range]++;
+				}
+			}
+		}
+		sum += row_sum;
+		nonzero += row_nonzero;
+	}
+
+	p->min = mn;
+	p->max = mx;
+	p->sum = sum;
+	p->nonzero = nonzero;
+	p->sum_squares = sum_squares;
+}
+
+	/*
+		PURPOSE: This function is the per worker body of topk_matrix, it keeps the k largest cells of its rows in its own heap.
+		INPUTS: first_row, end_row -> the rows to process. worker -> selects the heap to fill. arg -> the Topk_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void topk_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Topk_Job_t* job = arg;
+	const Matrix_t* m = job->m;
+	Matrix_Cell_t* heap = &job->heaps[(size_t) worker * job->k];
+	unsigned int size = 0;
+
+	for (unsigned int i = first_row; i < end_row; ++i) {
+		const unsigned int* row = &m->data[(size_t) i * m->cols];
+		for (unsigned int j = 0; j < m->cols; ++j) {
+			/* once full, most cells lose against the heap minimum without touching the heap */
+			if (size == job->k && row[j] <= heap[0].value) {
+				continue;
+			}
+			Matrix_Cell_t cell = {i, j, row[j]};
+			heap_offer(heap, &size, job->k, cell);
+		}
+	}
+	job->sizes[worker] = size;
+}
+
+	/*
+		PURPOSE: This function offers a cell to a min-heap bounded at k cells. It is added while there is room, otherwise it replaces the
+			heap minimum if it is larger.
+		INPUTS: heap -> the heap array. size -> the current heap size, updated. k -> the heap capacity. cell -> the candidate.
+		RETURNS: Nothing.
+	*/
+
+static void heap_offer (Matrix_Cell_t* heap, unsigned int* size, unsigned int k, Matrix_Cell_t cell) {
+
+	if (*size < k) {
+		unsigned int i = (*size)++;
+		while (i > 0 && heap[(i - 1) / 2].value > cell.value) {
+			heap[i] = heap[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+		heap[i] = cell;
+	}
+	else if (cell.value > heap[0].value) {
+		heap[0] = cell;
+		heap_sift_down(heap, *size, 0);
+	}
+}
+
+	/*
+		PURPOSE: This function restores the min-heap property below position i.
+		INPUTS: heap -> the heap array. size -> the heap size. i -> the position that may be larger than its children.
+		RETURNS: Nothing.
+	*/
+
+static void heap_sift_down (Matrix_Cell_t* heap, unsigned int size, unsigned int i) {
+
+	Matrix_Cell_t cell = heap[i];
+	for (;;) {
+		unsigned int child = 2 * i + 1;
+		if (child >= size) {
+			break;
+		}
+		if (child + 1 < size && heap[child + 1].value < heap[child].value) {
+			++child;
+		}
+		if (heap[child].value >= cell.value) {
+			break;
+		}
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = cell;
+}
@@ -0,0 +1,30 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include "matrix.h"
+
+typedef struct {
+	unsigned int min;
+	unsigned int max;
+	unsigned long long sum;
+	unsigned long long nonzero;
+	double mean;
+	double variance;
+	/* optional fixed-bin histogram over [hist_low, hist_high], counts is NULL when num_bins is 0 */
+	unsigned int num_bins;
+	unsigned int hist_low;
+	unsigned int hist_high;
+	unsigned long long* counts;
+}Matrix_Stats_t;
+
+typedef struct {
+	unsigned int row;
+	unsigned int col;
+	unsigned int value;
+}Matrix_Cell_t;
+
+bool stats_matrix (Matrix_t* m, Matrix_Stats_t* stats);
+void destroy_stats (Matrix_Stats_t* stats);
+unsigned int topk_matrix (Matrix_t* m, unsigned int k, Matrix_Cell_t* cells);
+
+#endif
@@ -0,0 +1,464 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+
+#include "stencil.h"
+#include "parallel.h"
+
+typedef struct {
+	const Matrix_t* src;
+	Matrix_t* dst;
+	Stencil_Op_t op; /* STENCIL_BOX is a weighted sum, with unit weights when no weights are given */
+	unsigned int height;
+	unsigned int width;
+	const unsigned int* weights; /* height x width kernel for the direct path, NULL when separable */
+	const unsigned int* col_weights; /* height weights of the separable path, NULL for unit weights */
+	const unsigned int* row_weights; /* width weights of the separable path, NULL for unit weights */
+	unsigned int identity; /* value of cells outside the matrix, and the starting value of every output */
+	unsigned int* scratch; /* scratch_cells per worker: the padded tile, the separable intermediate and one row of output */
+	size_t scratch_cells;
+	unsigned char* changed_rows; /* one flag per output row, set by the worker that computed the row when any of its cells changed */
+}Stencil_Job_t;
+
+/*protected functions*/
+static bool run_stencil (Stencil_Job_t* job);
+static void stencil_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+static void load_tile (const Stencil_Job_t* job, unsigned int first_row, unsigned int first_col, unsigned int tile_rows,
+	unsigned int tile_cols, unsigned int* pad);
+static void fill_cells (unsigned int* out, unsigned int value, unsigned int n);
+static bool store_cells (unsigned int* restrict dst, const unsigned int* restrict cells, unsigned int n);
+static void combine_cells (unsigned int* restrict out, const unsigned int* restrict in, unsigned int n, Stencil_Op_t op, unsigned int weight);
+static bool factor_kernel (const Matrix_t* kernel, unsigned int* col_weights, unsigned int* row_weights);
+static double seconds_now (void);
+
+	/*
+		PURPOSE: This function convolves a matrix with a kernel: dst(i,j) is the sum of kernel(a,b) * src(i + a - kh / 2, j + b - kw / 2)
+			over the kh x kw kernel, with cells outside src counting as zero and the arithmetic wrapping like add. A kernel that is the
+			product of a column and a row of whole numbers is applied as two one dimensional passes, kh + kw multiplies per cell instead
+			of kh * kw. The output is computed in cache sized tiles and the rows are split across workers.
+		INPUTS: src -> the matrix to filter. kernel -> the weights. dst -> receives the result, same dimensions as src, must not be src or kernel.
+		RETURNS: true on success, false on invalid parameters, mismatched dimensions or when memory ran out.
+	*/
+
+bool convolve_matrix (Matrix_t* src, Matrix_t* kernel, Matrix_t* dst) {
+
+	if(!src || !kernel || !dst || !src->data || !kernel->data || !dst->data)
+		return false;
+
+	if (dst->rows != src->rows || dst->cols != src->cols || dst == src || dst == kernel)
+		return false;
+
+	unsigned int* factors = calloc((size_t) kernel->rows + kernel->cols, sizeof(unsigned int));
+	if (!factors) {
+		return false;
+	}
+	const bool separable = (unsigned long long) kernel->rows * kernel->cols > (unsigned long long) kernel->rows + kernel->cols
+		&& factor_kernel(kernel, factors, factors + kernel->rows);
+
+	Stencil_Job_t job = {0};
+	job.src = src;
+	job.dst = dst;
+	job.op = STENCIL_BOX;
+	job.height = kernel->rows;
+	job.width = kernel->cols;
+	job.weights = separable ? NULL : kernel->data;
+	job.col_weights = factors;
+	job.row_weights = factors + kernel->rows;
+	job.identity = 0;
+	bool result = run_stencil(&job);
+	free(factors);
+	return result;
+}
+
+	/*
+		PURPOSE: This function applies a neighborhood filter over a height x width window anchored like a kernel of that size: STENCIL_BOX
+			sums the window with cells outside the matrix counting as zero, STENCIL_MIN and STENCIL_MAX take the smallest or largest cell of
+			the part of the window inside the matrix (erosion and dilation). All three are separable and run as two one dimensional passes.
+		INPUTS: src -> the matrix to filter. op -> the filter. height, width -> the window. dst -> receives the result, same dimensions as
+			src, must not be src.
+		RETURNS: true on success, false on invalid parameters, mismatched dimensions or when memory ran out.
+	*/
+
+bool stencil_matrix (Matrix_t* src, Stencil_Op_t op, unsigned int height, unsigned int width, Matrix_t* dst) {
+
+	if(!src || !dst || !src->data || !dst->data)
+		return false;
+
+	if (height == 0 || width == 0 || dst->rows != src->rows || dst->cols != src->cols || dst == src)
+		return false;
+
+	Stencil_Job_t job = {0};
+	job.src = src;
+	job.dst = dst;
+	job.op = op;
+	job.height = height;
+	job.width = width;
+	switch (op) {
+		case STENCIL_BOX: job.identity = 0; break;
+		case STENCIL_MIN: job.identity = UINT_MAX; break;
+		case STENCIL_MAX: job.identity = 0; break;
+		default: return false;
+	}
+	return run_stencil(&job);
+}
+
+	/*
+		PURPOSE: This function maps the name a user types to a stencil filter.
+		INPUTS: name -> one of box, min, max. op -> receives the filter.
+		RETURNS: true if the name is known, false otherwise.
+	*/
+
+bool stencil_op_from_name (const char* name, Stencil_Op_t* op) {
+
+	if(!name || !op)
+		return false;
+
+	static const char* names[] = {"box", "min", "max"};
+	for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		if (strncmp(name, names[i], strlen(names[i]) + 1) == 0) {
+			*op = (Stencil_Op_t) i;
+			return true;
+		}
+	}
+	return false;
+}
+
+	/*
+		PURPOSE: This function computes the same result as convolve_matrix with four plain nested loops and a bounds check per tap, as the
+			reference the tiled version is checked and timed against.
+		INPUTS: src -> the matrix to filter. kernel -> the weights. dst -> receives the result, same dimensions as src, must not be src or kernel.
+		RETURNS: true on success, false on invalid parameters or mismatched dimensions.
+	*/
+
+bool convolve_matrix_reference (Matrix_t* src, Matrix_t* kernel, Matrix_t* dst) {
+
+	if(!src || !kernel || !dst || !src->data || !kernel->data || !dst->data)
+		return false;
+
+	if (dst->rows != src->rows || dst->cols != src->cols || dst == src || dst == kernel)
+		return false;
+
+	const long anchor_row = kernel->rows / 2;
+	const long anchor_col = kernel->cols / 2;
+	for (unsigned int i = 0; i < src->rows; ++i) {
+		unsigned int changed = 0;
+		for (unsigned int j = 0; j < src->cols; ++j) {
+			unsigned int acc = 0;
+			for (unsigned int a = 0; a < kernel->rows; ++a) {
+				for (unsigned int b = 0; b < kernel->cols; ++b) {
+					const long si = (long) i + a - anchor_row;
+					const long sj = (long) j + b - anchor_col;
+					if (si >= 0 && si < src->rows && sj >= 0 && sj < src->cols) {
+						acc += kernel->data[(size_t) a * kernel->cols + b] * src->data[(size_t) si * src->cols + sj];
+					}
+				}
+			}
+			changed |= dst->data[(size_t) i * dst->cols + j] ^ acc;
+			dst->data[(size_t) i * dst->cols + j] = acc;
+		}
+		if (changed) {
+			mark_matrix_dirty(dst, i, i + 1);
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function times convolve_matrix against convolve_matrix_reference on the same inputs and checks they agree.
+		INPUTS: src -> the matrix to filter. kernel -> the weights. result -> receives the timings and whether the outputs matched.
+		RETURNS: true on success, false on invalid parameters or when the scratch matrices could not be created.
+	*/
+
+bool benchmark_convolve (Matrix_t* src, Matrix_t* kernel, Stencil_Bench_t* result) {
+
+	if(!src || !kernel || !result)
+		return false;
+
+	Matrix_t* tiled = NULL;
+	Matrix_t* reference = NULL;
+	if (!create_matrix(&tiled, "bench_tiled", src->rows, src->cols)
+		|| !create_matrix(&reference, "bench_reference", src->rows, src->cols)) {
+		destroy_matrix(&tiled);
+		return false;
+	}
+
+	unsigned int* factors = calloc((size_t) kernel->rows + kernel->cols, sizeof(unsigned int));
+	result->separable = factors && (unsigned long long) kernel->rows * kernel->cols > (unsigned long long) kernel->rows + kernel->cols
+		&& factor_kernel(kernel, factors, factors + kernel->rows);
+	free(factors);
+
+	double start = seconds_now();
+	bool ok = convolve_matrix(src, kernel, tiled);
+	result->tiled_seconds = seconds_now() - start;
+
+	start = seconds_now();
+	ok = ok && convolve_matrix_reference(src, kernel, reference);
+	result->reference_seconds = seconds_now() - start;
+
+	result->match = ok && equal_matrices(tiled, reference);
+	destroy_matrix(&tiled);
+	destroy_matrix(&reference);
+	return ok;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function gives every worker its scratch space, runs the tiles and marks the rows of the result that changed dirty.
+		INPUTS: job -> the filter to run, scratch and scratch_cells are filled in here.
+		RETURNS: true on success, false when memory ran out.
+	*/
+
+static bool run_stencil (Stencil_Job_t* job) {
+
+	const size_t halo_rows = (size_t) STENCIL_TILE_ROWS + job->height - 1;
+	const size_t halo_cols = (size_t) STENCIL_TILE_COLS + job->width - 1;
+	job->scratch_cells = halo_rows * halo_cols + halo_rows * STENCIL_TILE_COLS + STENCIL_TILE_COLS;
+	unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+	const unsigned int workers = parallel_partition(job->dst->rows, job->dst->cols, bounds);
+	job->scratch = malloc(job->scratch_cells * workers * sizeof(unsigned int));
+	job->changed_rows = calloc(job->dst->rows ? job->dst->rows : 1, 1);
+	if (!job->scratch || !job->changed_rows) {
+		free(job->scratch);
+		free(job->changed_rows);
+		return false;
+	}
+	parallel_for_bounds(bounds, workers, stencil_row_range, job);
+	/* marked here rather than by the workers, the dirty flags of neighbouring rows can share a block */
+	mark_matrix_rows_dirty(job->dst, job->changed_rows);
+	free(job->scratch);
+	free(job->changed_rows);
+	job->scratch = NULL;
+	job->changed_rows = NULL;
+	return true;
+}
+
+	/*
+		PURPOSE: This function is the per worker body of the filters. Each tile of output is computed from a copy of the source cells it
+			needs, halo included and padded with the identity where the window leaves the matrix, so the inner loops have no bounds checks
+			and run over contiguous rows that the compiler vectorizes. Each row of a tile is built in scratch and only stored when it differs.
+		INPUTS: first_row, end_row -> the output rows to compute. worker -> selects the scratch space. arg -> the Stencil_Job_t.
+		RETURNS: Nothing.
+	*/
+
+static void stencil_row_range (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Stencil_Job_t* job = arg;
+	Matrix_t* dst = job->dst;
+	unsigned int* pad = job->scratch + job->scratch_cells * worker;
+	unsigned int* temp = pad + ((size_t) STENCIL_TILE_ROWS + job->height - 1) * ((size_t) STENCIL_TILE_COLS + job->width - 1);
+	unsigned int* out = temp + ((size_t) STENCIL_TILE_ROWS + job->height - 1) * STENCIL_TILE_COLS;
+
+	for (unsigned int tr = first_row; tr < end_row; tr += STENCIL_TILE_ROWS) {
+		const unsigned int th = end_row - tr < STENCIL_TILE_ROWS ? end_row - tr : STENCIL_TILE_ROWS;
+		const unsigned int ph = th + job->height - 1;
+		for (unsigned int tc = 0; tc < dst->cols; tc += STENCIL_TILE_COLS) {
+			const unsigned int tw = dst->cols - tc < STENCIL_TILE_COLS ? dst->cols - tc : STENCIL_TILE_COLS;
+			const unsigned int pw = tw + job->width - 1;
+			load_tile(job, tr, tc, th, tw, pad);
+
+			if (job->weights) {
+				for (unsigned int i = 0; i < th; ++i) {
+					fill_cells(out, job->identity, tw);
+					for (unsigned int a = 0; a < job->height; ++a) {
+						for (unsigned int b = 0; b < job->width; ++b) {
+							const unsigned int weight = job->weights[(size_t) a * job->width + b];
+							if (weight != 0) {
+								combine_cells(out, &pad[(size_t) (i + a) * pw + b], tw, job->op, weight);
+							}
+						}
+					}
+					if (store_cells(&dst->data[(size_t) (tr + i) * dst->cols + tc], out, tw)) {
+						job->changed_rows[tr + i] = 1;
+					}
+				}
+				continue;
+			}
+
+			/* separable: along the rows into temp, then down the columns into the output */
+			for (unsigned int r = 0; r < ph; ++r) {
+				unsigned int* row = &temp[(size_t) r * tw];
+				fill_cells(row, job->identity, tw);
+				for (unsigned int b = 0; b < job->width; ++b) {
+					const unsigned int weight = job->row_weights ? job->row_weights[b] : 1;
+					if (weight != 0) {
+						combine_cells(row, &pad[(size_t) r * pw + b], tw, job->op, weight);
+					}
+				}
+			}
+			for (unsigned int i = 0; i < th; ++i) {
+				fill_cells(out, job->identity, tw);
+				for (unsigned int a = 0; a < job->height; ++a) {
+					const unsigned int weight = job->col_weights ? job->col_weights[a] : 1;
+					if (weight != 0) {
+						combine_cells(out, &temp[(size_t) (i + a) * tw], tw, job->op, weight);
+					}
+				}
+				if (store_cells(&dst->data[(size_t) (tr + i) * dst->cols + tc], out, tw)) {
+					job->changed_rows[tr + i] = 1;
+				}
+			}
+		}
+	}
+}
+
+	/*
+		PURPOSE: This function copies the source cells a tile of output depends on into a padded buffer, using the identity for cells
+			outside the matrix.
+		INPUTS: job -> the filter. first_row, first_col -> the top left output cell of the tile. tile_rows, tile_cols -> the size of the
+			tile. pad -> receives (tile_rows + height - 1) x (tile_cols + width - 1) cells.
+		RETURNS: Nothing.
+	*/
+
+static void load_tile (const Stencil_Job_t* job, unsigned int first_row, unsigned int first_col, unsigned int tile_rows,
+	unsigned int tile_cols, unsigned int* pad) {
+
+	const Matrix_t* src = job->src;
+	const unsigned int ph = tile_rows + job->height - 1;
+	const unsigned int pw = tile_cols + job->width - 1;
+	const long first_src_col = (long) first_col - job->width / 2;
+
+	/* columns [lo, hi) of each padded row lie inside the matrix */
+	long lo = first_src_col < 0 ? -first_src_col : 0;
+	long hi = (long) src->cols - first_src_col;
+	lo = lo > pw ? pw : lo;
+	hi = hi > pw ? pw : hi;
+	hi = hi < lo ? lo : hi;
+
+	for (unsigned int r = 0; r < ph; ++r) {
+		unsigned int* row = &pad[(size_t) r * pw];
+		const long sr = (long) first_row + r - job->height / 2;
+		if (sr < 0 || sr >= src->rows) {
+			fill_cells(row, job->identity, pw);
+			continue;
+		}
+		fill_cells(row, job->identity, lo);
+		memcpy(row + lo, &src->data[(size_t) sr * src->cols + first_src_col + lo], (hi - lo) * sizeof(unsigned int));
+		fill_cells(row + hi, job->identity, pw - hi);
+	}
+}
+
+	/*
+		PURPOSE: This function sets n cells to a value.
+		INPUTS: out -> the cells. value -> the value. n -> how many cells.
+		RETURNS: Nothing.
+	*/
+
+static void fill_cells (unsigned int* out, unsigned int value, unsigned int n) {
+
+	for (unsigned int j = 0; j < n; ++j) {
+		out[j] = value;
+	}
+}
+
+	/*
+		PURPOSE: This function copies n computed cells into the output when they differ from what is there.
+		INPUTS: dst -> the output cells. cells -> the computed cells. n -> how many cells.
+		RETURNS: true if the output changed.
+	*/
+
+static bool store_cells (unsigned int* restrict dst, const unsigned int* restrict cells, unsigned int n) {
+
+	if (memcmp(dst, cells, (size_t) n * sizeof(unsigned int)) == 0) {
+		return false;
+	}
+	memcpy(dst, cells, (size_t) n * sizeof(unsigned int));
+	return true;
+}
+
+	/*
+		PURPOSE: This function folds one shifted row of input into a row of output. The filter is chosen outside the loops so each loop is
+			a straight line over contiguous cells that vectorizes.
+		INPUTS: out -> the output row. in -> the input row, already offset by the tap. n -> how many cells. op -> the filter.
+			weight -> the tap weight for STENCIL_BOX.
+		RETURNS: Nothing.
+	*/
+
+static void combine_cells (unsigned int* restrict out, const unsigned int* restrict in, unsigned int n, Stencil_Op_t op, unsigned int weight) {
+
+	switch (op) {
+		case STENCIL_BOX:
+			if (weight == 1) {
+				for (unsigned int j = 0; j < n; ++j) out[j] += in[j];
+			}
+			else {
+				for (unsigned int j = 0; j < n; ++j) out[j] += weight * in[j];
+			}
+			break;
+		case STENCIL_MIN:
+			for (unsigned int j = 0; j < n; ++j) out[j] = in[j] < out[j] ? in[j] : out[j];
+			break;
+		case STENCIL_MAX:
+			for (unsigned int j = 0; j < n; ++j) out[j] = in[j] > out[j] ? in[j] : out[j];
+			break;
+	}
+}
+
+	/*
+		PURPOSE: This function checks whether a kernel is the product of a column and a row of whole numbers, kernel(a,b) = col(a) * row(b),
+			and finds them. The row is the first non zero row of the kernel divided by the greatest common divisor of its cells.
+		INPUTS: kernel -> the kernel. col_weights -> receives kernel->rows weights. row_weights -> receives kernel->cols weights.
+		RETURNS: true if the kernel factors exactly, false otherwise, including for an all zero kernel.
+	*/
+
+static bool factor_kernel (const Matrix_t* kernel, unsigned int* col_weights, unsigned int* row_weights) {
+
+	const unsigned int kh = kernel->rows;
+	const unsigned int kw = kernel->cols;
+	const unsigned int* k = kernel->data;
+
+	/* pivot on the first non zero cell */
+	size_t pivot = 0;
+	while (pivot < (size_t) kh * kw && k[pivot] == 0) {
+		++pivot;
+	}
+	if (pivot == (size_t) kh * kw) {
+		return false;
+	}
+	const unsigned int pivot_row = pivot / kw;
+	const unsigned int pivot_col = pivot % kw;
+
+	unsigned int g = 0;
+	for (unsigned int b = 0; b < kw; ++b) {
+		unsigned int x = k[(size_t) pivot_row * kw + b];
+		while (x) {
+			unsigned int r = g % x;
+			g = x;
+			x = r;
+		}
+	}
+	for (unsigned int b = 0; b < kw; ++b) {
+		row_weights[b] = k[(size_t) pivot_row * kw + b] / g;
+	}
+	for (unsigned int a = 0; a < kh; ++a) {
+		const unsigned int x = k[(size_t) a * kw + pivot_col];
+		if (x % row_weights[pivot_col] != 0) {
+			return false;
+		}
+		col_weights[a] = x / row_weights[pivot_col];
+	}
+	for (unsigned int a = 0; a < kh; ++a) {
+		for (unsigned int b = 0; b < kw; ++b) {
+			if ((unsigned long long) col_weights[a] * row_weights[b] != k[(size_t) a * kw + b]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+	/*
+		PURPOSE: This function reads a monotonic clock.
+		INPUTS: None.
+		RETURNS: the time in seconds.
+	*/
+
+static double seconds_now (void) {
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,29 @@
+#ifndef _STENCIL_H_
+#define _STENCIL_H_
+
+#include "matrix.h"
+
+/* output is computed in tiles of this many rows and columns, sized so a tile plus its halo stays in cache */
+#define STENCIL_TILE_ROWS 64
+#define STENCIL_TILE_COLS 512
+
+typedef enum {
+	STENCIL_BOX,
+	STENCIL_MIN,
+	STENCIL_MAX,
+}Stencil_Op_t;
+
+typedef struct {
+	double tiled_seconds;
+	double reference_seconds;
+	bool separable; /* the tiled run took the separable path */
+	bool match; /* both runs produced the same matrix */
+}Stencil_Bench_t;
+
+bool convolve_matrix (Matrix_t* src, Matrix_t* kernel, Matrix_t* dst);
+bool stencil_matrix (Matrix_t* src, Stencil_Op_t op, unsigned int height, unsigned int width, Matrix_t* dst);
+bool stencil_op_from_name (const char* name, Stencil_Op_t* op);
+bool convolve_matrix_reference (Matrix_t* src, Matrix_t* kernel, Matrix_t* dst);
+bool benchmark_convolve (Matrix_t* src, Matrix_t* kernel, Stencil_Bench_t* result);
+
+#endif
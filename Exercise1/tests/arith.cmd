@@ -0,0 +1,53 @@
+create a 2 3
+random a 0 9 81
+create b 2 3
+random b 0 9 82
+display a
+display b
+add a b a
+display a
++= a b
+display a
++= a missing
+create wide 3 2
++= a wide
+add a wide c
+scalar a sub 2
+display a
+scalar a mul 3
+display a
+scalar a and 12
+display a
+scalar a or 1
+display a
+scalar a xor 5
+display a
+scalar a min 6
+display a
+scalar a max 4
+display a
+scalar a add 4294967295
+display a
+scalar a sub 4294967295
+display a
+scalar a mul 1073741825
+display a
+scalar a pow 2
+create row 1 3
+random row 1 3 83
+create col 2 1
+random col 1 3 84
+display row
+display col
+broadcast b row add
+display b
+broadcast b col mul
+display b
+broadcast b row min
+display b
+broadcast b wide add
+create c 2 3
+add a b c
+display c
+add a b wide
+exit
@@ -0,0 +1,39 @@
+create x0 3 3
+random x0 0 9 31
+create x1 3 3
+random x1 0 9 32
+create y0 3 3
+random y0 0 9 33
+create y1 3 3
+random y1 0 9 34
+batch-create xs 2 3 3
+batch-create ys 2 3 3
+batch-set xs 0 x0
+batch-set xs 1 x1
+batch-set ys 0 y0
+batch-set ys 1 y1
+batch-sum xs
+sum x0
+sum x1
+batch-add xs ys sums
+add x0 y0 r
+batch-get sums 0 got
+equal r got
+add x1 y1 r
+batch-get sums 1 got
+equal r got
+batch-mul xs ys prods
+display x1
+display y1
+batch-get prods 1 got
+display got
+batch-add xs xs twice
+batch-shift xs l 1
+batch-equal xs twice
+batch-write xs
+batch-shift xs r 1
+batch-equal xs twice
+batch-get xs 2 got
+batch-set xs 0 y0
+batch-mul xs xs xs
+exit
@@ -0,0 +1,7 @@
+create x0 3 3
+random x0 0 9 31
+batch-read xs
+batch-get xs 0 got
+scalar x0 mul 2
+equal x0 got
+exit
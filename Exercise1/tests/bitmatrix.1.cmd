@@ -0,0 +1,37 @@
+create m 3 70
+random m 0 1 91
+pack m bm
+bitdisplay bm
+popcount bm
+sum m
+bitnot bm
+popcount bm
+bitnot bm
+unpack bm back
+equal m back
+bitshift bm l 5
+popcount bm
+bitshift bm r 64
+bitdisplay bm
+bitshift bm d 1
+popcount bm
+bitshift bm x 1
+create n 3 70
+random n 0 1 92
+pack n bn
+bitop and bm bn band
+bitop or bm bn bor
+bitop xor bm bn bxor
+popcount band
+popcount bor
+popcount bxor
+bitop add bm bn bad
+create k 70 2
+random k 0 1 93
+pack k bk
+bitmul bn bk prod
+bitdisplay prod
+bitmul bn bn prod
+bitmul bn bk bn
+bitwrite bn
+exit
@@ -0,0 +1,9 @@
+bitread bn
+popcount bn
+read bn
+create n 3 70
+random n 0 1 92
+unpack bn back
+equal n back
+bitread missing
+exit
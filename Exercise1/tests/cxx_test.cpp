@@ -0,0 +1,176 @@
+/*
+ * Links against libmatrix.a or libmatrix.so through the C++ wrappers in libmatrix.hpp and checks ownership moves, the status carried by
+ * libmatrix::Error and torn file handling. Prints every failed check and exits non zero if there was one.
+ *
+ * usage: cxx_test
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <unistd.h>
+
+#include "../libmatrix.hpp"
+
+using libmatrix::Context;
+using libmatrix::Error;
+using libmatrix::Matrix;
+
+static int failures = 0;
+
+#define EXPECT(cond) \
+	do { \
+		if (!(cond)) { \
+			std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* runs f and returns the status of the Error it throws, MATRIX_OK when it throws nothing */
+template <typename F>
+static Matrix_Status_t status_of (F f) {
+
+	try {
+		f();
+	}
+	catch (const Error& e) {
+		return e.status();
+	}
+	return MATRIX_OK;
+}
+
+static void test_matrix_moves () {
+
+	Matrix a("a", 2, 3);
+	a.set(1, 2, 7);
+
+	Matrix b(std::move(a));
+	EXPECT(!a);
+	EXPECT(a.get() == nullptr);
+	EXPECT(b && b.name() == "a" && b.rows() == 2 && b.cols() == 3);
+	EXPECT(b.at(1, 2) == 7);
+
+	Matrix c("c", 1, 1);
+	c = std::move(b);
+	EXPECT(!b);
+	EXPECT(c.name() == "a" && c.at(1, 2) == 7);
+
+	Matrix_t* raw = c.release();
+	EXPECT(!c);
+	Matrix adopted(raw);
+	EXPECT(adopted.get() == raw);
+}
+
+static void test_error_status () {
+
+	EXPECT(status_of([] { Matrix m("bad", 0, 3); }) == MATRIX_ERR_ARGS);
+	EXPECT(status_of([] { Matrix m("a name much longer than the limit", 1, 1); }) == MATRIX_ERR_ARGS);
+	EXPECT(status_of([] { Matrix::read("no_such_matrix_file"); }) == MATRIX_ERR_OPEN);
+
+	Matrix a("a", 2, 2);
+	Matrix b("b", 3, 3);
+	Matrix result("result", 2, 2);
+	EXPECT(status_of([&] { a.at(2, 0); }) == MATRIX_ERR_ARGS);
+	EXPECT(status_of([&] { a.add(b, result); }) == MATRIX_ERR_SHAPE);
+	EXPECT(status_of([&] { a.add(a, result); }) == MATRIX_OK);
+
+	try {
+		Matrix::read("no_such_matrix_file");
+	}
+	catch (const Error& e) {
+		EXPECT(std::string(e.what()) == matrix_status_string(MATRIX_ERR_OPEN));
+	}
+}
+
+static void test_read_write (const std::string& dir) {
+
+	const std::string filename = dir + "/m";
+	Matrix m("m", 4, 5);
+	unsigned int seed = 7;
+	m.randomize(0, 100, seed);
+	EXPECT(status_of([&] { m.write(filename); }) == MATRIX_OK);
+
+	Matrix read_back = Matrix::read(filename);
+	EXPECT(read_back == m);
+	EXPECT(read_back.name() == "m");
+
+	/* what an interrupted incremental write leaves behind */
+	FILE* f = std::fopen(filename.c_str(), "r+b");
+	EXPECT(f != nullptr);
+	if (f) {
+		std::fseek(f, -1, SEEK_END);
+		std::fputc(MATRIX_FILE_UPDATING, f);
+		std::fclose(f);
+	}
+	EXPECT(status_of([&] { Matrix::read(filename); }) == MATRIX_TORN_FILE);
+	EXPECT(status_of([&] { Matrix::read(filename, false); }) == MATRIX_TORN_FILE);
+
+	Matrix torn;
+	EXPECT(status_of([&] { torn = Matrix::read(filename, true); }) == MATRIX_OK);
+	EXPECT(torn && torn == m);
+
+	const std::string garbage = dir + "/garbage";
+	f = std::fopen(garbage.c_str(), "wb");
+	EXPECT(f != nullptr);
+	if (f) {
+		std::fputs("BITMAT01 is not a matrix", f);
+		std::fclose(f);
+	}
+	EXPECT(status_of([&] { Matrix::read(garbage, true); }) == MATRIX_ERR_FORMAT);
+
+	std::remove(filename.c_str());
+	std::remove(garbage.c_str());
+}
+
+static void test_context (const std::string& dir) {
+
+	Context ctx(4);
+	Matrix a("a", 2, 2);
+	a.set(0, 0, 3);
+	ctx.add(std::move(a));
+	EXPECT(!a);
+	ctx.add(Matrix("b", 1, 1));
+
+	Matrix found = ctx.find("a");
+	EXPECT(found.at(0, 0) == 3);
+	EXPECT(status_of([&] { ctx.find("missing"); }) == MATRIX_ERR_NOT_FOUND);
+
+	const std::string session = dir + "/session";
+	EXPECT(status_of([&] { ctx.save(session); }) == MATRIX_OK);
+
+	Matrix taken = ctx.take("a");
+	EXPECT(taken.at(0, 0) == 3);
+	EXPECT(status_of([&] { ctx.take("a"); }) == MATRIX_ERR_NOT_FOUND);
+
+	Context moved(std::move(ctx));
+	EXPECT(ctx.get() == nullptr);
+	EXPECT(moved.load(session) == 2);
+	EXPECT(moved.find("a") == taken);
+	EXPECT(status_of([&] { moved.load(dir + "/no_such_session"); }) == MATRIX_ERR_OPEN);
+
+	std::remove(session.c_str());
+}
+
+int main () {
+
+	char dir_template[] = "/tmp/cxx_test.XXXXXX";
+	const char* dir = mkdtemp(dir_template);
+	if (!dir) {
+		std::perror("mkdtemp");
+		return EXIT_FAILURE;
+	}
+
+	test_matrix_moves();
+	test_error_status();
+	test_read_write(dir);
+	test_context(dir);
+
+	rmdir(dir);
+	if (failures) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+	std::printf("PASS cxx_test\n");
+	return EXIT_SUCCESS;
+}
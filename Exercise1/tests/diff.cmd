@@ -0,0 +1,23 @@
+create a 200 30
+random a 0 100 8
+duplicate a b
+diff a b
+scalar b add 0
+diff a b
+create row 1 30
+random row 0 1 9
+broadcast b row add
+diff a b 3
+diff a b 3 1
+diff-first a b 2
+create c 30 200
+diff a c
+diff a missing
+create p 500 300
+random p 0 100 8
+duplicate p q
+scalar q xor 1
+diff p q 2
+scalar q xor 1
+diff p q
+exit
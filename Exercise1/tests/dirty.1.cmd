@@ -0,0 +1,11 @@
+create m 600 400
+random m 1 1000 51
+write m
+create keep 600 1
+random keep 0 300 52
+scalar keep min 1
+stats keep
+broadcast m keep mul
+write m
+sum m
+exit
@@ -0,0 +1,17 @@
+read m
+create m2 600 400
+random m2 1 1000 51
+create keep 600 1
+random keep 0 300 52
+scalar keep min 1
+broadcast m2 keep mul
+equal m m2
+sum m
+create band 600 1
+random band 0 1 53
+scalar band add 1
+broadcast m band mul
+write m
+broadcast m2 band mul
+sum m2
+exit
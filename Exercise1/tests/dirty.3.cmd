@@ -0,0 +1,3 @@
+read m
+sum m
+exit
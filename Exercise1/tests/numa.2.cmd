@@ -0,0 +1,8 @@
+create a 2 140000
+random a 0 9 101
+info a
+sum a
+percentile a 50
+sort a
+topk a 1
+exit
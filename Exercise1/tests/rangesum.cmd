@@ -0,0 +1,22 @@
+create a 4 5
+random a 0 9 11
+display a
+rangesum a 0 0 3 4
+sum a
+rangesum a 1 1 2 3
+rangesum a 2 4 2 4
+rangesum a 3 3 1 1
+rangesum a 0 0 4 0
+scalar a add 1
+rangesum a 1 1 2 3
+create big 700 300
+random big 0 1000 4
+sum big
+rangesum big 0 0 699 299
+rangesum big 350 0 699 299
+create row 1 300
+scalar row add 2
+broadcast big row add
+rangesum big 350 0 699 299
+rangesum big 0 0 349 299
+exit
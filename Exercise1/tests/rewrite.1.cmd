@@ -0,0 +1,12 @@
+create a 300 300
+random a 0 9 61
+write a
+write a
+write a
+scalar a add 1
+write a
+pack a a
+bitwrite a
+write a
+sum a
+exit
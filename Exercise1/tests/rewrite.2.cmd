@@ -0,0 +1,3 @@
+read a
+sum a
+exit
@@ -0,0 +1,54 @@
+#!/bin/sh
+# Runs the scripted sessions in this directory through matlab and compares what they print with name.expected.
+# name.cmd is a single session. name.1.cmd, name.2.cmd, ... are separate sessions run one after the other in the
+# same scratch directory, so a file written by one part can be read back by the next.
+# When the script is piped in matlab echoes it to stderr, so only stdout, the output of the commands, is compared.
+# A part can come with a .env file next to it (name.env or name.1.env) holding VAR=value lines for its environment.
+#
+# usage: sh tests/run_tests.sh <path to matlab>
+
+if [ $# -ne 1 ] || [ ! -x "$1" ]; then
+	echo "usage: $0 <path to matlab>" >&2
+	exit 2
+fi
+
+matlab=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+tests=$(cd "$(dirname "$0")" && pwd)
+passed=0
+failed=0
+
+for expected in "$tests"/*.expected; do
+	[ -f "$expected" ] || continue
+	name=$(basename "$expected" .expected)
+	scratch=$(mktemp -d)
+
+	for part in "$tests/$name.cmd" "$tests/$name".[0-9].cmd; do
+		if [ -f "$part" ]; then
+			vars=""
+			if [ -f "${part%.cmd}.env" ]; then
+				vars=$(cat "${part%.cmd}.env")
+			fi
+			(cd "$scratch" && env $vars "$matlab" < "$part") >> "$scratch/output" 2> /dev/null
+		fi
+	done
+
+	if [ ! -f "$scratch/output" ]; then
+		echo "FAIL $name (no .cmd file)"
+		failed=$((failed + 1))
+		rm -rf "$scratch"
+		continue
+	fi
+
+	if diff -u "$expected" "$scratch/output" > "$scratch/diff"; then
+		echo "PASS $name"
+		passed=$((passed + 1))
+	else
+		echo "FAIL $name"
+		cat "$scratch/diff"
+		failed=$((failed + 1))
+	fi
+	rm -rf "$scratch"
+done
+
+echo "$passed passed, $failed failed"
+[ $failed -eq 0 ]
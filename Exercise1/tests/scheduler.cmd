@@ -0,0 +1,33 @@
+create a 300 300
+create b 300 300
+random a 0 9 71
+random b 0 9 72
+add a b c
+add b a d
+equal c d
+sort a
+sum a
+write b
+scalar b add 1
+read b
+sum b
+add a b c
+sum c
+sync
+create e 2 2
+create f 2 2
+create g 2 2
+create h 2 2
+create i 2 2
+create j 2 2
+display a
+sum b
+sum c
+sum temp_mat
+create k 2 2
+create l 2 2
+sum a
+sum b
+sum k
+sum l
+exit
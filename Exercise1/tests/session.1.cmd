@@ -0,0 +1,6 @@
+create a 5 4
+random a 0 9 41
+create b 300 300
+random b 0 1000 42
+save-session s
+exit
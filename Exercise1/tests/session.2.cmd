@@ -0,0 +1,12 @@
+load-session s
+create a2 5 4
+random a2 0 9 41
+create b2 300 300
+random b2 0 1000 42
+equal a a2
+equal b b2
+sum b
+scalar a add 1
+save-session s
+load-session missing
+exit
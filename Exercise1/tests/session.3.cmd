@@ -0,0 +1,7 @@
+load-session s
+create a2 5 4
+random a2 0 9 41
+scalar a2 add 1
+equal a a2
+display a
+exit
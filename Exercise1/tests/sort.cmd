@@ -0,0 +1,25 @@
+create s 4 5
+random s 0 20 21
+display s
+sortrows s 2
+display s
+sortrows s 9
+percentile s 0
+percentile s 50
+percentile s 100
+percentile s 101
+sort s
+display s
+create big 600 400
+random big 0 4000000000 5
+percentile big 25
+percentile big 100
+sort big
+topk big 1
+percentile big 25
+percentile big 100
+create dup 1 8
+scalar dup add 7
+sort dup
+display dup
+exit
@@ -0,0 +1,15 @@
+create z 4 4
+stats z
+scalar z add 3
+stats z
+create a 8 8
+random a 1 100 42
+sum a
+stats a
+stats a 4 1 100
+topk a 5
+create t 2 2
+random t 0 9 43
+topk t 4000000000
+stats missing
+exit
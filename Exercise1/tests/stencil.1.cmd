@@ -0,0 +1,20 @@
+create a 12 10
+random a 0 9 3
+create ones 3 3
+scalar ones add 1
+convolve a ones box_conv
+stencil a box 3 3 box_sum
+equal box_conv box_sum
+create small 4 5
+random small 0 9 11
+display small
+stencil small box 3 3 small_box
+display small_box
+stencil small min 1 3 small_box
+display small_box
+stencil small max 3 1 small_box
+display small_box
+stencil small box 3 3 small_box
+stencil small box 3 3 small
+equal small small_box
+exit
@@ -0,0 +1,22 @@
+create a 12 10
+random a 0 9 3
+create col 3 1
+random col 1 4 13
+create row 1 3
+random row 1 4 14
+create kc 3 3
+broadcast kc col add
+create kr 3 3
+broadcast kr row add
+create k 3 3
+broadcast k col add
+broadcast k row add
+display k
+convolve a kc sep
+convolve a kr direct
++= sep direct
+convolve a k direct
+equal direct sep
+convolve a k a
+equal a sep
+exit
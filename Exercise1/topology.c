@@ -0,0 +1,330 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <dirent.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+
+#include "topology.h"
+#include "parallel.h"
+
+#define TOPOLOGY_MOVE_PAGES_BATCH 1024
+
+typedef struct {
+	unsigned int num_nodes;
+	bool fake;
+	Placement_t policy;
+	int node_ids[TOPOLOGY_MAX_NODES]; /* kernel node number of each node index */
+	cpu_set_t cpus[TOPOLOGY_MAX_NODES];
+}Topology_t;
+
+static Topology_t topology;
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+
+/*protected functions*/
+static void discover_topology (void);
+static bool parse_cpulist (const char* path, cpu_set_t* cpus);
+static void touch_rows (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg);
+
+	/*
+		PURPOSE: This function reports how many NUMA nodes matrices are spread over. The topology is read from sysfs once, or faked with
+			MATLAB_NUMA_NODES=<n>, which splits the online CPUs into n nodes so the placement logic can be exercised on a single node machine.
+		INPUTS: None.
+		RETURNS: the node count, at least 1.
+	*/
+
+unsigned int topology_node_count (void) {
+
+	pthread_once(&topology_once, discover_topology);
+	return topology.num_nodes;
+}
+
+	/*
+		PURPOSE: This function tells whether the topology comes from MATLAB_NUMA_NODES rather than the machine.
+		INPUTS: None.
+		RETURNS: true for a fake topology.
+	*/
+
+bool topology_is_fake (void) {
+
+	pthread_once(&topology_once, discover_topology);
+	return topology.fake;
+}
+
+	/*
+		PURPOSE: This function maps a worker of a parallel kernel to a node. Workers are split into contiguous groups, one per node, so the
+			contiguous row ranges of parallel_for_rows form one contiguous block of rows per node.
+		INPUTS: worker -> the worker index. workers -> the number of workers in the kernel.
+		RETURNS: the node index of the worker.
+	*/
+
+unsigned int topology_worker_node (unsigned int worker, unsigned int workers) {
+
+	pthread_once(&topology_once, discover_topology);
+	if (workers == 0) {
+		return 0;
+	}
+	return (unsigned int) ((unsigned long long) worker * topology.num_nodes / workers);
+}
+
+	/*
+		PURPOSE: This function restricts the calling thread to the CPUs of one node.
+		INPUTS: node -> the node index.
+		RETURNS: true if the affinity was set, false for an invalid node or when the system refused.
+	*/
+
+bool topology_pin_to_node (unsigned int node) {
+
+	pthread_once(&topology_once, discover_topology);
+	if (node >= topology.num_nodes || CPU_COUNT(&topology.cpus[node]) == 0) {
+		return false;
+	}
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &topology.cpus[node]) == 0;
+}
+
+	/*
+		PURPOSE: This function allocates the data of a large matrix with NUMA aware placement. With the first-touch policy, the default on
+			more than one node, every row block is zeroed by a worker pinned to the node that parallel kernels will later process it on.
+			With MATLAB_NUMA_POLICY=interleave the pages are spread round robin over all nodes instead. MATLAB_NUMA_POLICY=heap turns this off.
+		INPUTS: m -> the matrix, rows and cols set and data not yet allocated.
+		RETURNS: true if m->data was allocated here, false if the matrix should come from the heap as usual.
+	*/
+
+bool topology_alloc_matrix (Matrix_t* m) {
+
+	if(!m || m->data)
+		return false;
+
+	pthread_once(&topology_once, discover_topology);
+	const size_t bytes = (size_t) m->rows * m->cols * sizeof(unsigned int);
+	if (topology.num_nodes < 2 || topology.policy == PLACEMENT_HEAP || bytes < TOPOLOGY_MIN_BYTES) {
+		return false;
+	}
+
+	void* data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	m->data = data;
+	m->mapped_bytes = bytes;
+	m->placement = topology.policy;
+
+	if (topology.policy == PLACEMENT_INTERLEAVE) {
+		if (!topology.fake) {
+			unsigned long mask[(TOPOLOGY_MAX_NODES + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))] = {0};
+			for (unsigned int n = 0; n < topology.num_nodes; ++n) {
+				const int id = topology.node_ids[n];
+				mask[id / (8 * sizeof(unsigned long))] |= 1UL << (id % (8 * sizeof(unsigned long)));
+			}
+			/* best effort, a refused policy just leaves the kernel default */
+			syscall(SYS_mbind, data, bytes, MPOL_INTERLEAVE, mask, TOPOLOGY_MAX_NODES + 1, 0);
+		}
+		return true;
+	}
+
+	parallel_for_rows(m->rows, m->cols, touch_rows, m);
+	return true;
+}
+
+	/*
+		PURPOSE: This function reports how the pages of a matrix are spread over the nodes. On a real topology the kernel is asked where each
+			page lives; on a fake one the placement the policy would have produced is reported.
+		INPUTS: m -> the matrix. pages_per_node -> TOPOLOGY_MAX_NODES counters, filled with the number of pages on each node index.
+		RETURNS: true if pages_per_node was filled, false for heap matrices or when the kernel could not be asked.
+	*/
+
+bool topology_matrix_placement (Matrix_t* m, unsigned long long* pages_per_node) {
+
+	if(!m || !m->data || !pages_per_node || m->placement == PLACEMENT_HEAP)
+		return false;
+
+	pthread_once(&topology_once, discover_topology);
+	memset(pages_per_node, 0, TOPOLOGY_MAX_NODES * sizeof(unsigned long long));
+	const long page_size = sysconf(_SC_PAGESIZE);
+	const size_t bytes = (size_t) m->rows * m->cols * sizeof(unsigned int);
+	const size_t num_pages = (bytes + page_size - 1) / page_size;
+
+	if (topology.fake) {
+		if (m->placement == PLACEMENT_INTERLEAVE) {
+			for (unsigned int n = 0; n < topology.num_nodes; ++n) {
+				pages_per_node[n] = num_pages / topology.num_nodes + (n < num_pages % topology.num_nodes);
+			}
+			return true;
+		}
+		unsigned int bounds[PARALLEL_MAX_WORKERS + 1];
+		const unsigned int workers = parallel_partition(m->rows, m->cols, bounds);
+		const size_t row_bytes = (size_t) m->cols * sizeof(unsigned int);
+		for (unsigned int w = 0; w < workers; ++w) {
+			const size_t first_page = bounds[w] * row_bytes / page_size;
+			const size_t end_page = (bounds[w + 1] * row_bytes + page_size - 1) / page_size;
+			pages_per_node[topology_worker_node(w, workers)] += end_page - first_page;
+		}
+		return true;
+	}
+
+	void* pages[TOPOLOGY_MOVE_PAGES_BATCH];
+	int status[TOPOLOGY_MOVE_PAGES_BATCH];
+	for (size_t first = 0; first < num_pages; first += TOPOLOGY_MOVE_PAGES_BATCH) {
+		const size_t count = num_pages - first < TOPOLOGY_MOVE_PAGES_BATCH ? num_pages - first : TOPOLOGY_MOVE_PAGES_BATCH;
+		for (size_t i = 0; i < count; ++i) {
+			pages[i] = (unsigned char*) m->data + (first + i) * page_size;
+		}
+		/* with no target nodes move_pages only reports where each page is */
+		if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0) != 0) {
+			return false;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			for (unsigned int n = 0; n < topology.num_nodes; ++n) {
+				if (status[i] == topology.node_ids[n]) {
+					pages_per_node[n]++;
+					break;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+/*Protected Functions in C*/
+
+	/*
+		PURPOSE: This function fills in the topology, from MATLAB_NUMA_NODES when it is set and from /sys/devices/system/node otherwise,
+			falling back to a single node holding every CPU. Only nodes with CPUs this process can use become placement targets. It also reads the placement policy from MATLAB_NUMA_POLICY.
+		INPUTS: None.
+		RETURNS: Nothing.
+	*/
+
+static void discover_topology (void) {
+
+	memset(&topology, 0, sizeof(topology));
+	cpu_set_t online;
+	CPU_ZERO(&online);
+	if (sched_getaffinity(0, sizeof(online), &online) != 0) {
+		CPU_SET(0, &online);
+	}
+
+	const char* fake_nodes = getenv(TOPOLOGY_FAKE_NODES_ENV);
+	if (fake_nodes && atoi(fake_nodes) > 0) {
+		/* split the usable CPUs into contiguous groups, sharing them when there are more nodes than CPUs */
+		unsigned int nodes = atoi(fake_nodes) > TOPOLOGY_MAX_NODES ? TOPOLOGY_MAX_NODES : atoi(fake_nodes);
+		unsigned int num_cpus = CPU_COUNT(&online);
+		topology.num_nodes = nodes;
+		topology.fake = true;
+		for (unsigned int n = 0; n < nodes; ++n) {
+			topology.node_ids[n] = n;
+			CPU_ZERO(&topology.cpus[n]);
+		}
+		for (unsigned int cpu = 0, seen = 0; cpu < CPU_SETSIZE && seen < num_cpus; ++cpu) {
+			if (!CPU_ISSET(cpu, &online)) {
+				continue;
+			}
+			if (num_cpus >= nodes) {
+				CPU_SET(cpu, &topology.cpus[(unsigned long long) seen * nodes / num_cpus]);
+			}
+			else {
+				for (unsigned int n = seen; n < nodes; n += num_cpus) {
+					CPU_SET(cpu, &topology.cpus[n]);
+				}
+			}
+			++seen;
+		}
+	}
+	else {
+		DIR* dir = opendir("/sys/devices/system/node");
+		struct dirent* entry;
+		while (dir && (entry = readdir(dir)) && topology.num_nodes < TOPOLOGY_MAX_NODES) {
+			int id;
+			char path[300];
+			if (sscanf(entry->d_name, "node%d", &id) != 1 || id < 0 || id >= TOPOLOGY_MAX_NODES) {
+				continue;
+			}
+			snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", entry->d_name);
+			cpu_set_t cpus;
+			if (!parse_cpulist(path, &cpus)) {
+				continue;
+			}
+			/* memory only nodes, and nodes whose CPUs this process may not run on, get no workers and so no rows */
+			CPU_AND(&cpus, &cpus, &online);
+			if (CPU_COUNT(&cpus) == 0) {
+				continue;
+			}
+			topology.node_ids[topology.num_nodes] = id;
+			topology.cpus[topology.num_nodes++] = cpus;
+		}
+		if (dir) {
+			closedir(dir);
+		}
+		if (topology.num_nodes == 0) {
+			topology.num_nodes = 1;
+			topology.node_ids[0] = 0;
+			topology.cpus[0] = online;
+		}
+	}
+
+	topology.policy = topology.num_nodes > 1 ? PLACEMENT_FIRST_TOUCH : PLACEMENT_HEAP;
+	const char* policy = getenv(TOPOLOGY_POLICY_ENV);
+	if (policy && strcmp(policy, "interleave") == 0) {
+		topology.policy = PLACEMENT_INTERLEAVE;
+	}
+	else if (policy && strcmp(policy, "firsttouch") == 0) {
+		topology.policy = PLACEMENT_FIRST_TOUCH;
+	}
+	else if (policy && strcmp(policy, "heap") == 0) {
+		topology.policy = PLACEMENT_HEAP;
+	}
+}
+
+	/*
+		PURPOSE: This function reads a sysfs CPU list such as "0-3,8-11".
+		INPUTS: path -> the file to read. cpus -> receives the CPUs in the list.
+		RETURNS: true if the file could be read, false otherwise.
+	*/
+
+static bool parse_cpulist (const char* path, cpu_set_t* cpus) {
+
+	FILE* f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+	CPU_ZERO(cpus);
+	unsigned int first, last;
+	int separator;
+	while (fscanf(f, "%u", &first) == 1) {
+		last = first;
+		separator = fgetc(f);
+		if (separator == '-') {
+			if (fscanf(f, "%u", &last) != 1) {
+				break;
+			}
+			separator = fgetc(f);
+		}
+		for (unsigned int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+			CPU_SET(cpu, cpus);
+		}
+		if (separator != ',') {
+			break;
+		}
+	}
+	fclose(f);
+	return true;
+}
+
+	/*
+		PURPOSE: This function is the per worker body of the first-touch allocation, it writes every page of its rows so they are placed
+			on the node the worker is pinned to.
+		INPUTS: first_row, end_row -> the rows to touch. worker -> unused. arg -> the matrix.
+		RETURNS: Nothing.
+	*/
+
+static void touch_rows (unsigned int first_row, unsigned int end_row, unsigned int worker, void* arg) {
+
+	Matrix_t* m = arg;
+	memset(&m->data[(size_t) first_row * m->cols], 0, (size_t) (end_row - first_row) * m->cols * sizeof(unsigned int));
+}
@@ -0,0 +1,21 @@
+#ifndef _TOPOLOGY_H_
+#define _TOPOLOGY_H_
+
+#include "matrix.h"
+
+#define TOPOLOGY_MAX_NODES 64
+/* matrices smaller than this stay on the heap, placement does not matter for them */
+#define TOPOLOGY_MIN_BYTES (1 << 20)
+
+/* environment variables read once at start up */
+#define TOPOLOGY_FAKE_NODES_ENV "MATLAB_NUMA_NODES"
+#define TOPOLOGY_POLICY_ENV "MATLAB_NUMA_POLICY"
+
+unsigned int topology_node_count (void);
+bool topology_is_fake (void);
+unsigned int topology_worker_node (unsigned int worker, unsigned int workers);
+bool topology_pin_to_node (unsigned int node);
+bool topology_alloc_matrix (Matrix_t* m);
+bool topology_matrix_placement (Matrix_t* m, unsigned long long* pages_per_node);
+
+#endif